@@ -0,0 +1,76 @@
+#include "alloc_counter.hpp"
+#include "message_arena.hpp"
+#include <cstdlib>
+#include <new>
+
+// Replacement global allocation functions. Besides one thread-local
+// increment per heap allocation they honour
+// MessageArena::RouteGlobalAllocations and ignore frees of arena memory.
+namespace {
+    thread_local uint64_t t_allocations = 0;
+
+    void* countedAllocate(std::size_t size) {
+        if (MessageArena* arena = MessageArena::routedForThisThread()) {
+            return arena->allocate(size == 0 ? 1 : size, alignof(std::max_align_t));
+        }
+        ++t_allocations;
+        if (size == 0) {
+            size = 1;
+        }
+        while (true) {
+            if (void* p = std::malloc(size)) {
+                return p;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void* countedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+        std::size_t align = static_cast<std::size_t>(alignment);
+        if (MessageArena* arena = MessageArena::routedForThisThread()) {
+            return arena->allocate(size == 0 ? 1 : size, align);
+        }
+        ++t_allocations;
+        size = (size + align - 1) / align * align;
+        while (true) {
+            if (void* p = std::aligned_alloc(align, size == 0 ? align : size)) {
+                return p;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void release(void* p) noexcept {
+        MessageArena* arena = MessageArena::existingForThisThread();
+        if (arena && arena->owns(p)) {
+            return; // Reclaimed when the arena is reset
+        }
+        std::free(p);
+    }
+}
+
+uint64_t AllocationCounter::threadAllocations() {
+    return t_allocations;
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { release(p); }
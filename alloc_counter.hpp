@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts global operator new calls made by the current thread. Used to
+// verify that hot paths run without touching the heap.
+namespace AllocationCounter {
+    uint64_t threadAllocations();
+}
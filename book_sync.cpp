@@ -0,0 +1,279 @@
+#include "book_sync.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+
+namespace {
+    // [action, price, amount] for change notifications, [price, amount] for snapshots
+    void decodeBookLevels(const arena_json& data, const char* side, std::vector<BookLevel>& levels) {
+        levels.clear();
+        auto it = data.find(side);
+        if (it == data.end() || !it->is_array()) {
+            return;
+        }
+        levels.reserve(it->size());
+        // Numbers arrive as doubles; rounding to the book's scale recovers the exact decimal
+        auto price = [](const arena_json& value) {
+            return Decimal::fromDouble(value.get<double>(), OrderBook::kPriceScale).units();
+        };
+        auto amount = [](const arena_json& value) {
+            return Decimal::fromDouble(value.get<double>(), OrderBook::kAmountScale).units();
+        };
+        for (const auto& level : *it) {
+            if (level.size() == 3) {
+                const auto& action = level[0].get_ref<const arena_json::string_t&>();
+                levels.push_back({action == "delete" ? BookLevel::DELETE
+                                  : action == "new" ? BookLevel::NEW : BookLevel::CHANGE,
+                                  price(level[1]), amount(level[2])});
+            } else if (level.size() == 2) {
+                levels.push_back({BookLevel::SET, price(level[0]), amount(level[1])});
+            }
+        }
+    }
+}
+
+void BookUpdate::decode(const arena_json& data) {
+    changeId = data.value("change_id", uint64_t(0));
+    auto prev = data.find("prev_change_id");
+    hasPrevChangeId = prev != data.end() && prev->is_number();
+    prevChangeId = hasPrevChangeId ? prev->get<uint64_t>() : 0;
+    auto type = data.find("type");
+    isSnapshot = type != data.end() && type->is_string() && *type == "snapshot";
+    timestamp = data.value("timestamp", uint64_t(0));
+    decodeBookLevels(data, "bids", bids);
+    decodeBookLevels(data, "asks", asks);
+}
+
+void OrderBook::clear() {
+    m_bids.clear();
+    m_asks.clear();
+    m_changeId = 0;
+    m_timestamp = 0;
+}
+
+template <typename Side>
+void OrderBook::applyLevels(Side& side, const std::vector<BookLevel>& levels) {
+    for (const BookLevel& level : levels) {
+        if (level.action == BookLevel::DELETE || (level.action == BookLevel::SET && level.amount <= 0)) {
+            side.erase(level.price);
+        } else {
+            side[level.price] = level.amount;
+        }
+    }
+    while (side.size() > kMaxDepth) {
+        side.erase(std::prev(side.end()));
+    }
+}
+
+void OrderBook::apply(const BookUpdate& update) {
+    applyLevels(m_bids, update.bids);
+    applyLevels(m_asks, update.asks);
+    m_changeId = update.changeId;
+    m_timestamp = update.timestamp;
+}
+
+bool OrderBook::bestBid(Decimal& price, Decimal& amount) const {
+    if (m_bids.empty()) {
+        return false;
+    }
+    price = Decimal(m_bids.begin()->first, kPriceScale);
+    amount = Decimal(m_bids.begin()->second, kAmountScale);
+    return true;
+}
+
+bool OrderBook::bestAsk(Decimal& price, Decimal& amount) const {
+    if (m_asks.empty()) {
+        return false;
+    }
+    price = Decimal(m_asks.begin()->first, kPriceScale);
+    amount = Decimal(m_asks.begin()->second, kAmountScale);
+    return true;
+}
+
+BookSynchronizer::BookSynchronizer(RequestSnapshot requestSnapshot, const std::string& labels,
+                                   std::chrono::milliseconds minSnapshotInterval)
+    : m_requestSnapshot(std::move(requestSnapshot)), m_minSnapshotInterval(minSnapshotInterval) {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    m_gaps = &metrics.counter("deribit_book_sequence_gaps_total", labels);
+    m_replayed = &metrics.counter("deribit_book_replayed_updates_total", labels);
+    m_snapshotRequests = &metrics.counter("deribit_book_snapshot_requests_total", labels);
+    m_staleBooks = &metrics.gauge("deribit_book_stale_books", labels);
+    m_resyncLatency = &metrics.histogram("deribit_book_resync_us", labels);
+}
+
+void BookSynchronizer::requestSnapshot(const std::string& channel, ChannelState& state) {
+    const auto now = std::chrono::steady_clock::now();
+    if (state.lastSnapshotRequest.time_since_epoch().count() != 0 &&
+        now - state.lastSnapshotRequest < m_minSnapshotInterval) {
+        return;
+    }
+    state.snapshotPending = true;
+    state.lastSnapshotRequest = now;
+    m_snapshotRequests->add();
+    m_requestSnapshot(channel, state.instrument);
+}
+
+void BookSynchronizer::startResync(const std::string& channel, ChannelState& state) {
+    if (!state.stale) {
+        state.stale = true;
+        state.staleSince = std::chrono::steady_clock::now();
+        m_staleBooks->add(1);
+    }
+    state.buffered.clear();
+    requestSnapshot(channel, state);
+}
+
+void BookSynchronizer::UpdateBuffer::push_back(const BookUpdate& update) {
+    if (m_count == kMaxBuffered) {
+        // The snapshot will be newer than what is dropped; if not, replay
+        // detects the hole and resyncs again
+        pop_front();
+    }
+    if (m_count == m_slots.size()) {
+        // Every slot in use and still below the cap: unroll the ring and
+        // add a slot at its end
+        std::rotate(m_slots.begin(), m_slots.begin() + static_cast<std::ptrdiff_t>(m_head), m_slots.end());
+        m_head = 0;
+        m_slots.emplace_back();
+    }
+    m_slots[(m_head + m_count) % m_slots.size()] = update;
+    m_count++;
+}
+
+void BookSynchronizer::finishResync(const std::string& channel, ChannelState& state) {
+    state.synced = true;
+    // A reply still in flight is dropped by onSnapshot(); don't wait for it
+    state.snapshotPending = false;
+    if (state.stale) {
+        state.stale = false;
+        m_staleBooks->add(-1);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - state.staleSince).count();
+        m_resyncLatency->record(elapsed);
+        LOG_INFO("Book {} resynchronized in {} us at change_id {}", channel, elapsed, state.book.changeId());
+    }
+}
+
+bool BookSynchronizer::onUpdate(std::string_view channel, std::string_view instrument, const BookUpdate& update) {
+    auto it = m_channels.find(channel);
+    if (it == m_channels.end()) {
+        it = m_channels.try_emplace(std::string(channel)).first;
+        it->second.instrument = std::string(instrument);
+    }
+    const std::string& name = it->first;
+    ChannelState& state = it->second;
+
+    if (update.isSnapshot || !update.hasPrevChangeId) {
+        // Full state: the subscription's initial snapshot, or a grouped
+        // channel where every message replaces the book
+        state.book.clear();
+        state.book.apply(update);
+        state.buffered.clear();
+        finishResync(name, state);
+        return true;
+    }
+
+    if (state.stale) {
+        state.buffered.push_back(update);
+        if (!state.snapshotPending) {
+            requestSnapshot(name, state);
+        }
+        return false;
+    }
+
+    if (!state.synced || update.prevChangeId != state.book.changeId()) {
+        if (state.synced) {
+            m_gaps->add();
+            LOG_WARNING("Book {} sequence gap: expected prev_change_id {}, got {}", name,
+                        state.book.changeId(), update.prevChangeId);
+        }
+        startResync(name, state);
+        state.buffered.push_back(update);
+        return false;
+    }
+
+    state.book.apply(update);
+    return true;
+}
+
+bool BookSynchronizer::onUpdate(std::string_view channel, const arena_json& data) {
+    if (!data.is_object()) {
+        return false;
+    }
+    auto instrument = data.find("instrument_name");
+    if (instrument == data.end() || !instrument->is_string()) {
+        return false;
+    }
+    const auto& name = instrument->get_ref<const arena_json::string_t&>();
+    m_scratch.decode(data);
+    return onUpdate(channel, std::string_view(name.data(), name.size()), m_scratch);
+}
+
+void BookSynchronizer::onSnapshot(const std::string& channel, const arena_json& result) {
+    m_scratch.decode(result);
+    m_scratch.isSnapshot = true;
+    onSnapshot(channel, m_scratch);
+}
+
+void BookSynchronizer::onSnapshot(const std::string& channel, const BookUpdate& snapshot) {
+    auto it = m_channels.find(channel);
+    if (it == m_channels.end()) {
+        return;
+    }
+    ChannelState& state = it->second;
+    state.snapshotPending = false;
+    if (!state.stale) {
+        return; // Already resynchronized by a subscription snapshot
+    }
+
+    state.book.clear();
+    state.book.apply(snapshot);
+
+    // Replay what arrived while waiting; anything the snapshot already covers is skipped
+    size_t replayed = 0;
+    while (!state.buffered.empty()) {
+        const BookUpdate& update = state.buffered.front();
+        if (update.changeId > state.book.changeId()) {
+            if (update.prevChangeId != state.book.changeId()) {
+                LOG_WARNING("Book {} snapshot at change_id {} does not connect to buffered updates; retrying",
+                            channel, state.book.changeId());
+                requestSnapshot(channel, state);
+                return;
+            }
+            state.book.apply(update);
+            replayed++;
+        }
+        state.buffered.pop_front();
+    }
+    m_replayed->add(replayed);
+    finishResync(channel, state);
+}
+
+void BookSynchronizer::onSnapshotFailed(const std::string& channel) {
+    auto it = m_channels.find(channel);
+    if (it != m_channels.end()) {
+        it->second.snapshotPending = false;
+    }
+}
+
+void BookSynchronizer::reset() {
+    for (auto& entry : m_channels) {
+        if (entry.second.stale) {
+            m_staleBooks->add(-1);
+        }
+    }
+    m_channels.clear();
+}
+
+const OrderBook* BookSynchronizer::book(std::string_view channel) const {
+    auto it = m_channels.find(channel);
+    if (it == m_channels.end() || it->second.stale || !it->second.synced) {
+        return nullptr;
+    }
+    return &it->second.book;
+}
+
+bool BookSynchronizer::isStale(std::string_view channel) const {
+    auto it = m_channels.find(channel);
+    return it != m_channels.end() && it->second.stale;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "decimal.hpp"
+#include "message_arena.hpp"
+
+class MetricCounter;
+class MetricGauge;
+class LatencyHistogram;
+
+struct BookLevel {
+    enum Action : uint8_t {
+        NEW,
+        CHANGE,
+        DELETE,
+        SET         // Snapshot level: [price, amount], amount 0 removes
+    };
+    Action action;
+    int64_t price;      // Units of OrderBook::kPriceScale
+    int64_t amount;     // Units of OrderBook::kAmountScale
+};
+
+// One decoded book.* notification or get_order_book result
+struct BookUpdate {
+    uint64_t changeId = 0;
+    uint64_t prevChangeId = 0;
+    bool hasPrevChangeId = false;   // Raw and interval channels chain updates; grouped ones don't
+    bool isSnapshot = false;
+    uint64_t timestamp = 0;
+    std::vector<BookLevel> bids;
+    std::vector<BookLevel> asks;
+
+    // Replaces the contents with a book.* notification or get_order_book
+    // result; the level buffers keep their capacity, so decoding into the
+    // same update again does not allocate
+    void decode(const arena_json& data);
+};
+
+class OrderBook {
+public:
+    // Fixed scales fine enough for every Deribit tick size and lot, so
+    // levels are keyed and compared as plain integers
+    static constexpr int kPriceScale = 10;
+    static constexpr int kAmountScale = 8;
+    // Levels kept per side; deeper ones are dropped, so snapshots are
+    // requested at this depth. A valid get_order_book depth
+    static constexpr size_t kMaxDepth = 1000;
+
+    using Bids = std::pmr::map<int64_t, int64_t, std::greater<int64_t>>;
+    using Asks = std::pmr::map<int64_t, int64_t>;
+
+    OrderBook() = default;
+    OrderBook(const OrderBook&) = delete;
+    OrderBook& operator=(const OrderBook&) = delete;
+
+    void clear();
+    void apply(const BookUpdate& update);
+
+    bool bestBid(Decimal& price, Decimal& amount) const;
+    bool bestAsk(Decimal& price, Decimal& amount) const;
+
+    // Price units -> amount units
+    const Bids& bids() const { return m_bids; }
+    const Asks& asks() const { return m_asks; }
+    uint64_t changeId() const { return m_changeId; }
+    uint64_t timestamp() const { return m_timestamp; }
+
+private:
+    template <typename Side>
+    static void applyLevels(Side& side, const std::vector<BookLevel>& levels);
+
+    // Level nodes are recycled through the pool: once a book has reached
+    // its working size, adding and removing levels does not touch the heap
+    std::pmr::unsynchronized_pool_resource m_pool;
+    Bids m_bids{&m_pool};
+    Asks m_asks{&m_pool};
+    uint64_t m_changeId = 0;
+    uint64_t m_timestamp = 0;
+};
+
+// Keeps a book per book.* channel consistent with the exchange. Each
+// update must continue from the previous one (prev_change_id equals the
+// last applied change_id). On a gap the channel is marked stale, a fresh
+// snapshot is requested and further updates are buffered; when the
+// snapshot arrives the buffered updates newer than it are replayed and
+// the channel is live again. IO thread only.
+class BookSynchronizer {
+public:
+    // Asks for a full snapshot of the instrument; the answer must come back
+    // through onSnapshot() or onSnapshotFailed() for the same channel
+    using RequestSnapshot = std::function<void(const std::string& channel, const std::string& instrument)>;
+
+    static constexpr size_t kMaxBuffered = 10000;
+    // A stale channel asks for at most one snapshot per interval; updates
+    // arriving in between only buffer, and the first one after it retries
+    static constexpr std::chrono::milliseconds kMinSnapshotInterval{500};
+
+    explicit BookSynchronizer(RequestSnapshot requestSnapshot, const std::string& labels = "",
+                              std::chrono::milliseconds minSnapshotInterval = kMinSnapshotInterval);
+
+    // Returns true if the channel's book is in sync after the update
+    bool onUpdate(std::string_view channel, std::string_view instrument, const BookUpdate& update);
+    void onSnapshot(const std::string& channel, const BookUpdate& snapshot);
+    // Decode the notification's data or the get_order_book result into a
+    // reused update first; allocation-free once the book is warm
+    bool onUpdate(std::string_view channel, const arena_json& data);
+    void onSnapshot(const std::string& channel, const arena_json& result);
+    // The next update on a still-stale channel requests a new snapshot
+    void onSnapshotFailed(const std::string& channel);
+
+    // Connection lost: every book must be rebuilt from a new subscription
+    void reset();
+
+    // nullptr while the channel is unknown or stale
+    const OrderBook* book(std::string_view channel) const;
+    bool isStale(std::string_view channel) const;
+
+private:
+    // Updates received while stale, oldest first, at most kMaxBuffered. A
+    // ring of reusable slots: buffering copies into a slot's existing
+    // level buffers, so repeated resyncs stop allocating once it has grown.
+    class UpdateBuffer {
+    public:
+        bool empty() const { return m_count == 0; }
+        const BookUpdate& front() const { return m_slots[m_head]; }
+        void pop_front() {
+            m_head = (m_head + 1) % m_slots.size();
+            m_count--;
+        }
+        void push_back(const BookUpdate& update);
+        void clear() {
+            m_head = 0;
+            m_count = 0;
+        }
+
+    private:
+        std::vector<BookUpdate> m_slots;
+        size_t m_head = 0;
+        size_t m_count = 0;
+    };
+
+    struct ChannelState {
+        std::string instrument;
+        OrderBook book;
+        bool synced = false;
+        bool stale = false;
+        bool snapshotPending = false;
+        std::chrono::steady_clock::time_point staleSince;
+        std::chrono::steady_clock::time_point lastSnapshotRequest;
+        UpdateBuffer buffered;
+    };
+
+    void startResync(const std::string& channel, ChannelState& state);
+    void requestSnapshot(const std::string& channel, ChannelState& state);
+    void finishResync(const std::string& channel, ChannelState& state);
+
+    RequestSnapshot m_requestSnapshot;
+    std::chrono::milliseconds m_minSnapshotInterval;
+    std::map<std::string, ChannelState, std::less<>> m_channels;
+    BookUpdate m_scratch;
+
+    MetricCounter* m_gaps;
+    MetricCounter* m_replayed;
+    MetricCounter* m_snapshotRequests;
+    MetricGauge* m_staleBooks;
+    LatencyHistogram* m_resyncLatency;
+};
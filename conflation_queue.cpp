@@ -0,0 +1,39 @@
+#include "conflation_queue.hpp"
+#include "logger.hpp"
+#include <cstring>
+
+ConflationQueue::ConflationQueue()
+    : m_slots(new Slot[kMaxInstruments]),
+      m_latest(kMaxInstruments) {
+}
+
+size_t ConflationQueue::slotFor(std::string_view instrument) {
+    auto it = m_index.find(instrument);
+    if (it != m_index.end()) {
+        return it->second;
+    }
+
+    size_t index = m_count.load(std::memory_order_relaxed);
+    if (index == kMaxInstruments || instrument.size() >= kMaxNameLength) {
+        LOG_WARNING("Conflation queue cannot track instrument: {}", instrument);
+        m_index.emplace(instrument, kMaxInstruments); // Warn only once
+        return kMaxInstruments;
+    }
+
+    std::memcpy(m_slots[index].name, instrument.data(), instrument.size());
+    m_slots[index].name[instrument.size()] = '\0';
+    m_index.emplace(instrument, index);
+    m_count.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+bool ConflationQueue::latest(const std::string& instrument, MarketState& out) const {
+    size_t count = m_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        if (instrument == m_slots[i].name) {
+            m_slots[i].state.load(out);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <map>
+#include "seqlock.hpp"
+#include "market_data.hpp"
+
+// Conflating hand-off of per-instrument market state from the IO thread to
+// any number of consumer threads. The IO thread overwrites one slot per
+// instrument and never waits; a consumer only ever sees the newest value of
+// each instrument that changed since its previous poll, so falling behind
+// costs skipped intermediate updates rather than a growing backlog.
+class ConflationQueue {
+public:
+    static constexpr size_t kMaxInstruments = 1024;
+    static constexpr size_t kMaxNameLength = 64;
+
+    class Consumer {
+    public:
+        Consumer() : m_seen(kMaxInstruments, 0) {}
+
+    private:
+        friend class ConflationQueue;
+        std::vector<uint64_t> m_seen;
+        uint64_t m_generation = 0;
+    };
+
+    ConflationQueue();
+
+    // Producer side (IO thread only). `apply` mutates the instrument's latest
+    // state in place; the result is then published as one snapshot.
+    template <typename Apply>
+    bool update(std::string_view instrument, Apply&& apply) {
+        size_t index = slotFor(instrument);
+        if (index == kMaxInstruments) {
+            return false;
+        }
+        MarketState& state = m_latest[index];
+        apply(state);
+        m_slots[index].state.store(state);
+        m_generation.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Calls handler(instrument, state) once for every
+    // instrument updated since the consumer's last poll and returns how many
+    // were delivered.
+    template <typename Handler>
+    size_t poll(Consumer& consumer, Handler&& handler) const {
+        uint64_t generation = m_generation.load(std::memory_order_acquire);
+        if (generation == consumer.m_generation) {
+            return 0;
+        }
+        consumer.m_generation = generation;
+
+        size_t delivered = 0;
+        size_t count = m_count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const Slot& slot = m_slots[i];
+            if (slot.state.version() == consumer.m_seen[i]) {
+                continue;
+            }
+            MarketState state;
+            consumer.m_seen[i] = slot.state.load(state);
+            handler(slot.name, state);
+            ++delivered;
+        }
+        return delivered;
+    }
+
+    bool latest(const std::string& instrument, MarketState& out) const;
+    size_t instrumentCount() const { return m_count.load(std::memory_order_acquire); }
+
+private:
+    struct alignas(64) Slot {
+        SeqLock<MarketState> state;
+        char name[kMaxNameLength] = {};
+    };
+
+    size_t slotFor(std::string_view instrument);
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<size_t> m_count{0};
+    std::atomic<uint64_t> m_generation{0};
+
+    // Producer-private
+    std::vector<MarketState> m_latest;
+    std::map<std::string, size_t, std::less<>> m_index; // Transparent: lookups by string_view
+};
@@ -0,0 +1,136 @@
+#include "decimal.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+Decimal Decimal::fromDouble(double value, int scale) {
+    return Decimal(std::llround(value * static_cast<double>(kPow10[scale])), scale);
+}
+
+Decimal Decimal::fromShortestDouble(double value, int maxScale) {
+    for (int scale = 0; scale < maxScale; ++scale) {
+        const int64_t units = std::llround(value * static_cast<double>(kPow10[scale]));
+        if (static_cast<double>(units) / static_cast<double>(kPow10[scale]) == value) {
+            return Decimal(units, scale);
+        }
+    }
+    return fromDouble(value, maxScale);
+}
+
+std::from_chars_result Decimal::fromChars(const char* first, const char* last, Decimal& value) {
+    const char* p = first;
+    const bool negative = p != last && *p == '-';
+    if (negative) {
+        ++p;
+    }
+
+    uint64_t units = 0;
+    int scale = 0;
+    bool digits = false;
+    bool point = false;
+    for (; p != last; ++p) {
+        if (*p == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (*p < '0' || *p > '9') {
+            break;
+        }
+        if (point && scale == kMaxScale) {
+            return {p, std::errc::result_out_of_range};
+        }
+        const uint64_t digit = static_cast<uint64_t>(*p - '0');
+        if (units > (static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) - digit) / 10) {
+            return {p, std::errc::result_out_of_range};
+        }
+        units = units * 10 + digit;
+        scale += point;
+        digits = true;
+    }
+    if (!digits) {
+        return {first, std::errc::invalid_argument};
+    }
+
+    value = Decimal(negative ? -static_cast<int64_t>(units) : static_cast<int64_t>(units), scale);
+    return {p, std::errc()};
+}
+
+std::to_chars_result Decimal::toChars(char* first, char* last) const {
+    const uint64_t magnitude = m_units < 0 ? 0 - static_cast<uint64_t>(m_units) : static_cast<uint64_t>(m_units);
+    const uint64_t divisor = static_cast<uint64_t>(kPow10[m_scale]);
+    uint64_t fraction = magnitude % divisor;
+
+    char* p = first;
+    if (m_units < 0) {
+        if (p == last) {
+            return {last, std::errc::value_too_large};
+        }
+        *p++ = '-';
+    }
+    std::to_chars_result result = std::to_chars(p, last, magnitude / divisor);
+    if (result.ec != std::errc() || fraction == 0) {
+        return result;
+    }
+
+    int digits = m_scale;
+    while (fraction % 10 == 0) {
+        fraction /= 10;
+        --digits;
+    }
+    p = result.ptr;
+    if (last - p < digits + 1) {
+        return {last, std::errc::value_too_large};
+    }
+    *p++ = '.';
+    for (int i = digits - 1; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    return {p + digits, std::errc()};
+}
+
+std::string Decimal::toString() const {
+    char buffer[48];
+    std::to_chars_result result = toChars(buffer, buffer + sizeof(buffer));
+    return std::string(buffer, result.ptr);
+}
+
+double Decimal::toDouble() const {
+    return static_cast<double>(m_units) / static_cast<double>(kPow10[m_scale]);
+}
+
+int64_t Decimal::divide(int64_t value, int64_t divisor, Rounding rounding) {
+    int64_t quotient = value / divisor;
+    const int64_t remainder = value % divisor;
+    if (remainder == 0) {
+        return quotient;
+    }
+    switch (rounding) {
+        case Rounding::FLOOR:
+            return remainder < 0 ? quotient - 1 : quotient;
+        case Rounding::CEIL:
+            return remainder > 0 ? quotient + 1 : quotient;
+        case Rounding::NEAREST:
+        default:
+            if (std::llabs(remainder) * 2 >= divisor) {
+                quotient += value < 0 ? -1 : 1;
+            }
+            return quotient;
+    }
+}
+
+Decimal Decimal::rescale(int scale, Rounding rounding) const {
+    if (scale >= m_scale) {
+        return Decimal(m_units * kPow10[scale - m_scale], scale);
+    }
+    return Decimal(divide(m_units, kPow10[m_scale - scale], rounding), scale);
+}
+
+Decimal Decimal::roundToTick(const Decimal& tick, Rounding rounding) const {
+    if (tick.m_units <= 0) {
+        return *this;
+    }
+    const int scale = m_scale > tick.m_scale ? m_scale : tick.m_scale;
+    const int64_t ticks = divide(rescale(scale).m_units, tick.rescale(scale).m_units, rounding);
+    return Decimal(ticks * tick.m_units, tick.m_scale);
+}
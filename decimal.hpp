@@ -0,0 +1,82 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+
+// Fixed-point decimal: an integer count of 10^-scale units. Prices and
+// amounts parsed from user input or exchange data keep their exact
+// decimal value, tick rounding is integer arithmetic, and formatting
+// never goes through double or the heap.
+//
+// Mixed-scale operations bring both sides to the larger scale; values are
+// expected to fit int64 there (18 significant digits).
+class Decimal {
+public:
+    static constexpr int kMaxScale = 18;
+
+    enum class Rounding {
+        NEAREST,    // Half away from zero
+        FLOOR,
+        CEIL
+    };
+
+    constexpr Decimal() = default;
+    constexpr Decimal(int64_t units, int scale) : m_units(units), m_scale(static_cast<int8_t>(scale)) {}
+
+    // Nearest value with the given scale
+    static Decimal fromDouble(double value, int scale);
+    // Shortest decimal, at most maxScale places, that converts back to
+    // exactly this double; for exchange values like tick_size = 0.0001
+    static Decimal fromShortestDouble(double value, int maxScale = 12);
+
+    // Parses [-]digits[.digits]; the scale is the number of fraction
+    // digits. Like std::from_chars, stops at the first character that does
+    // not fit and reports it in ptr.
+    static std::from_chars_result fromChars(const char* first, const char* last, Decimal& value);
+    // Shortest form: trailing fraction zeros and a bare point are dropped
+    std::to_chars_result toChars(char* first, char* last) const;
+
+    std::string toString() const;
+    double toDouble() const;
+
+    int64_t units() const { return m_units; }
+    int scale() const { return m_scale; }
+    bool isZero() const { return m_units == 0; }
+
+    Decimal rescale(int scale, Rounding rounding = Rounding::NEAREST) const;
+    // Nearest multiple of tick in the given direction, at the tick's scale
+    Decimal roundToTick(const Decimal& tick, Rounding rounding) const;
+
+    friend bool operator==(const Decimal& a, const Decimal& b) { return compare(a, b) == 0; }
+    friend bool operator!=(const Decimal& a, const Decimal& b) { return compare(a, b) != 0; }
+    friend bool operator<(const Decimal& a, const Decimal& b) { return compare(a, b) < 0; }
+    friend bool operator>(const Decimal& a, const Decimal& b) { return compare(a, b) > 0; }
+    friend bool operator<=(const Decimal& a, const Decimal& b) { return compare(a, b) <= 0; }
+    friend bool operator>=(const Decimal& a, const Decimal& b) { return compare(a, b) >= 0; }
+
+    static int64_t pow10(int exponent) { return kPow10[exponent]; }
+
+private:
+    static int compare(const Decimal& a, const Decimal& b) {
+        if (a.m_scale == b.m_scale) {
+            return a.m_units < b.m_units ? -1 : a.m_units > b.m_units;
+        }
+        const int scale = a.m_scale > b.m_scale ? a.m_scale : b.m_scale;
+        const int64_t x = a.m_units * kPow10[scale - a.m_scale];
+        const int64_t y = b.m_units * kPow10[scale - b.m_scale];
+        return x < y ? -1 : x > y;
+    }
+
+    static int64_t divide(int64_t value, int64_t divisor, Rounding rounding);
+
+    static constexpr int64_t kPow10[kMaxScale + 1] = {
+        1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL,
+        1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL,
+        100000000000000LL, 1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+        1000000000000000000LL
+    };
+
+    int64_t m_units = 0;
+    int8_t m_scale = 0;
+};
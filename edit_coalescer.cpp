@@ -0,0 +1,101 @@
+#include "edit_coalescer.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "tracing.hpp"
+
+EditCoalescer::EditCoalescer(NextRequestId nextRequestId, SendEdit sendEdit, const std::string& labels)
+    : m_nextRequestId(std::move(nextRequestId)),
+      m_sendEdit(std::move(sendEdit)) {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    m_sent = &metrics.counter("deribit_order_edits_sent_total", labels);
+    m_coalesced = &metrics.counter("deribit_order_edits_coalesced_total", labels);
+    m_rejected = &metrics.counter("deribit_order_edits_rejected_total", labels);
+}
+
+void EditCoalescer::sendLocked(std::unique_lock<std::mutex>& lock, const std::string& orderId, OrderState& state,
+                               Decimal amount, Decimal price, uint64_t traceId) {
+    // Register the id before sending so the response can never be processed first
+    const int id = m_nextRequestId();
+    state.inFlightId = id;
+    state.hasPending = false;
+    m_requests[id] = orderId;
+
+    lock.unlock();
+    m_sent->add();
+    {
+        TraceContext trace(traceId);
+        m_sendEdit(id, orderId, amount, price);
+    }
+    lock.lock();
+}
+
+EditCoalescer::Result EditCoalescer::amend(const std::string& orderId, const Decimal& amount, const Decimal& price) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    OrderState& state = m_orders[orderId];
+
+    if (state.inFlightId >= 0) {
+        // Later amendments win field by field; zero keeps the earlier value
+        if (!state.hasPending) {
+            state.amount = Decimal();
+            state.price = Decimal();
+        }
+        state.hasPending = true;
+        state.traceId = Tracer::currentTraceId();
+        if (amount.units() > 0) {
+            state.amount = amount;
+        }
+        if (price.units() > 0) {
+            state.price = price;
+        }
+        m_coalesced->add();
+        LOG_INFO("Edit for order {} coalesced behind request {}", orderId, state.inFlightId);
+        return Result::COALESCED;
+    }
+
+    sendLocked(lock, orderId, state, amount, price, Tracer::currentTraceId());
+    return Result::SENT;
+}
+
+bool EditCoalescer::onResponse(int requestId, bool success) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto request = m_requests.find(requestId);
+    if (request == m_requests.end()) {
+        return false;
+    }
+    const std::string orderId = std::move(request->second);
+    m_requests.erase(request);
+
+    auto it = m_orders.find(orderId);
+    if (it == m_orders.end()) {
+        return true;
+    }
+    OrderState& state = it->second;
+    state.inFlightId = -1;
+
+    if (!success) {
+        m_rejected->add();
+        if (state.hasPending) {
+            LOG_WARNING("Edit for order {} rejected; dropping pending amendment", orderId);
+        }
+        m_orders.erase(it);
+        return true;
+    }
+
+    if (state.hasPending) {
+        sendLocked(lock, orderId, state, state.amount, state.price, state.traceId);
+    } else {
+        m_orders.erase(it);
+    }
+    return true;
+}
+
+void EditCoalescer::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_orders.clear();
+    m_requests.clear();
+}
+
+size_t EditCoalescer::inFlight() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_requests.size();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include "decimal.hpp"
+
+class MetricCounter;
+
+// Keeps at most one private/edit in flight per order. Amendments made
+// while an edit is unacknowledged are merged into a single pending edit
+// holding the latest requested state, which is sent when the in-flight
+// edit is answered. Intermediate states the exchange would overwrite
+// anyway are never sent.
+//
+// amend() is called from the trading thread, onResponse() from the IO
+// thread; sends happen outside the lock so a blocked send never stalls
+// response handling. Each edit is sent under the trace of the latest
+// amendment merged into it, also when the IO thread sends it.
+class EditCoalescer {
+public:
+    // Sends private/edit with the given request id. Zero amount or price
+    // means "leave unchanged".
+    using SendEdit = std::function<void(int requestId, const std::string& orderId, const Decimal& amount, const Decimal& price)>;
+    using NextRequestId = std::function<int()>;
+
+    enum class Result {
+        SENT,           // Sent now
+        COALESCED       // Merged into the pending edit behind an in-flight one
+    };
+
+    EditCoalescer(NextRequestId nextRequestId, SendEdit sendEdit, const std::string& labels = "");
+
+    Result amend(const std::string& orderId, const Decimal& amount, const Decimal& price);
+
+    // Feed every response; returns false if the id was not an edit. A
+    // successful ack releases the pending edit; a rejected edit drops it,
+    // since the order is likely filled or cancelled.
+    bool onResponse(int requestId, bool success);
+
+    // Connection lost: outstanding edits will never be answered
+    void reset();
+
+    size_t inFlight() const;
+
+private:
+    struct OrderState {
+        int inFlightId = -1;
+        bool hasPending = false;
+        Decimal amount;
+        Decimal price;
+        uint64_t traceId = 0;   // Of the latest pending amendment
+    };
+
+    // Takes the edit by value: the lock is released while sending and
+    // amend() may then overwrite the state it came from
+    void sendLocked(std::unique_lock<std::mutex>& lock, const std::string& orderId, OrderState& state,
+                    Decimal amount, Decimal price, uint64_t traceId);
+
+    NextRequestId m_nextRequestId;
+    SendEdit m_sendEdit;
+    mutable std::mutex m_mutex;
+    std::map<std::string, OrderState> m_orders;
+    std::map<int, std::string> m_requests;     // In-flight request id -> order id
+
+    MetricCounter* m_sent;
+    MetricCounter* m_coalesced;
+    MetricCounter* m_rejected;
+};
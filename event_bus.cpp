@@ -0,0 +1,68 @@
+#include "event_bus.hpp"
+#include <thread>
+
+EventBus::EventBus(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_ring.reset(new MarketEvent[size]);
+    m_mask = size - 1;
+}
+
+void EventBus::publish(const MarketEvent& event) {
+    uint64_t seq = m_published.load(std::memory_order_relaxed);
+    const uint64_t capacity = m_mask + 1;
+
+    if (seq >= m_gate + capacity) {
+        m_gate = minimumCursor();
+        if (seq >= m_gate + capacity) {
+            // Lossless: wait for the slowest consumer to free a slot
+            m_stalls.fetch_add(1, std::memory_order_relaxed);
+            do {
+                std::this_thread::yield();
+                m_gate = minimumCursor();
+            } while (seq >= m_gate + capacity);
+        }
+    }
+
+    m_ring[seq & m_mask] = event;
+    m_published.store(seq + 1, std::memory_order_release);
+}
+
+uint64_t EventBus::minimumCursor() const {
+    // Pairs with the fence in addConsumer(): either this scan sees a joining
+    // consumer's cursor or that consumer starts after every sequence the
+    // scan lets the producer overwrite
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t minimum = m_published.load(std::memory_order_relaxed);
+    for (const Consumer& consumer : m_consumers) {
+        uint64_t cursor = consumer.m_cursor.load(std::memory_order_acquire);
+        if (cursor < minimum) {
+            minimum = cursor;
+        }
+    }
+    return minimum;
+}
+
+EventBus::Consumer* EventBus::addConsumer() {
+    std::lock_guard<std::mutex> lock(m_consumersMutex);
+    for (Consumer& consumer : m_consumers) {
+        if (!consumer.m_inUse) {
+            consumer.m_inUse = true;
+            // Gate the producer from here on, then start at whatever it has
+            // published by the time the producer is guaranteed to see us
+            consumer.m_cursor.store(m_published.load(std::memory_order_acquire), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            consumer.m_cursor.store(m_published.load(std::memory_order_acquire), std::memory_order_release);
+            return &consumer;
+        }
+    }
+    return nullptr;
+}
+
+void EventBus::removeConsumer(Consumer* consumer) {
+    std::lock_guard<std::mutex> lock(m_consumersMutex);
+    consumer->m_cursor.store(kInactive, std::memory_order_release);
+    consumer->m_inUse = false;
+}
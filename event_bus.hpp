@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "market_data.hpp"
+
+// Lossless single-producer multi-consumer ring buffer (disruptor style).
+// The IO thread publishes decoded MarketEvents; each consumer owns a
+// sequence cursor and reads events in place, so every consumer sees the
+// full stream without copies or locks. When the ring is full the producer
+// waits for the slowest consumer; those waits are counted so back-pressure
+// is visible instead of silently dropping events.
+class EventBus {
+public:
+    static constexpr size_t kMaxConsumers = 16;
+
+    class Consumer {
+    public:
+        uint64_t cursor() const { return m_cursor.load(std::memory_order_relaxed); }
+
+    private:
+        friend class EventBus;
+        alignas(64) std::atomic<uint64_t> m_cursor{kInactive};
+        bool m_inUse = false; // Guarded by EventBus::m_consumersMutex
+    };
+
+    // Capacity is rounded up to a power of two
+    explicit EventBus(size_t capacity = 65536);
+
+    // Producer side (IO thread only)
+    void publish(const MarketEvent& event);
+
+    // Consumers start at the next event published after registration and
+    // may join while the producer is running. Returns nullptr when all
+    // consumer slots are taken.
+    Consumer* addConsumer();
+    void removeConsumer(Consumer* consumer);
+
+    // Calls handler(const MarketEvent&) for up to maxBatch available events
+    // and returns how many were consumed. Events must not be retained past
+    // the handler call.
+    template <typename Handler>
+    size_t poll(Consumer& consumer, Handler&& handler, size_t maxBatch = 256) {
+        uint64_t next = consumer.m_cursor.load(std::memory_order_relaxed);
+        uint64_t available = m_published.load(std::memory_order_acquire);
+        if (available - next > maxBatch) {
+            available = next + maxBatch;
+        }
+        for (uint64_t seq = next; seq < available; ++seq) {
+            handler(static_cast<const MarketEvent&>(m_ring[seq & m_mask]));
+        }
+        consumer.m_cursor.store(available, std::memory_order_release);
+        return static_cast<size_t>(available - next);
+    }
+
+    // Back-pressure observability
+    uint64_t published() const { return m_published.load(std::memory_order_acquire); }
+    uint64_t producerStalls() const { return m_stalls.load(std::memory_order_relaxed); }
+    uint64_t lag(const Consumer& consumer) const { return published() - consumer.cursor(); }
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    static constexpr uint64_t kInactive = UINT64_MAX;
+
+    uint64_t minimumCursor() const;
+
+    std::unique_ptr<MarketEvent[]> m_ring;
+    size_t m_mask;
+    Consumer m_consumers[kMaxConsumers];
+    std::mutex m_consumersMutex;
+
+    alignas(64) std::atomic<uint64_t> m_published{0};
+    // Producer-private cache of the slowest consumer, refreshed only when the
+    // ring looks full
+    uint64_t m_gate = 0;
+    std::atomic<uint64_t> m_stalls{0};
+};
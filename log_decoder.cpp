@@ -0,0 +1,50 @@
+// Renders a binary log written by Logger as the familiar text format:
+//   2024-12-27 10:15:03.042 [INFO] Sending request to: private/buy?...
+//
+// Usage: log_decoder <log.bin> [--with-source]
+
+#include "log_reader.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <log.bin> [--with-source]" << std::endl;
+        return 1;
+    }
+    const bool withSource = argc > 2 && std::string(argv[2]) == "--with-source";
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+    const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    BinaryLog::Decoder decoder(data);
+    if (!decoder.hasMagic()) {
+        std::cerr << argv[1] << " is not a binary log" << std::endl;
+        return 1;
+    }
+
+    BinaryLog::Decoder::Message message;
+    BinaryLog::Decoder::Status status;
+    while ((status = decoder.next(message)) == BinaryLog::Decoder::OK) {
+        const std::string time = BinaryLog::formatTime(message.timestampNs);
+        if (!message.format) {
+            std::cout << time << " [UNKNOWN] " << message.text() << std::endl;
+            continue;
+        }
+        std::cout << time << " [" << BinaryLog::levelString(message.format->level) << "] ";
+        if (withSource) {
+            std::cout << message.format->file << ":" << message.format->line << " ";
+        }
+        std::cout << message.text() << '\n';
+    }
+    if (status == BinaryLog::Decoder::CORRUPT) {
+        std::cerr << "Corrupt record, stopping" << std::endl;
+        return 1;
+    }
+    return 0;
+}
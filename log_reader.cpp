@@ -0,0 +1,189 @@
+#include "log_reader.hpp"
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+
+namespace BinaryLog {
+    const char* levelString(Logger::LogLevel level) {
+        switch (level) {
+            case Logger::INFO: return "INFO";
+            case Logger::WARNING: return "WARNING";
+            case Logger::ERROR: return "ERROR";
+            case Logger::TRADE: return "TRADE";
+            case Logger::LATENCY: return "LATENCY";
+            default: return "UNKNOWN";
+        }
+    }
+
+    std::string render(const std::string& format, const std::vector<std::string>& args) {
+        std::string out;
+        out.reserve(format.size() + 32);
+        size_t next = 0;
+        for (size_t i = 0; i < format.size(); ++i) {
+            if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '}') {
+                out += next < args.size() ? args[next] : "{}";
+                ++next;
+                ++i;
+            } else if ((format[i] == '{' || format[i] == '}') && i + 1 < format.size() && format[i + 1] == format[i]) {
+                out += format[i];
+                ++i;
+            } else {
+                out += format[i];
+            }
+        }
+        // Arguments without a placeholder are still shown rather than lost
+        for (; next < args.size(); ++next) {
+            out += " " + args[next];
+        }
+        return out;
+    }
+
+    std::string formatTime(uint64_t timestampNs) {
+        std::time_t seconds = static_cast<std::time_t>(timestampNs / 1000000000ULL);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+        char millis[8];
+        std::snprintf(millis, sizeof(millis), ".%03u", static_cast<unsigned>(timestampNs / 1000000ULL % 1000));
+        return std::string(buffer) + millis;
+    }
+
+    std::string Decoder::Message::text() const {
+        return format ? render(format->text, args) : "<format " + std::to_string(formatId) + ">";
+    }
+
+    Decoder::Decoder(const std::string& data) : m_data(data) {
+        char magic[sizeof(kMagic)];
+        m_hasMagic = read(magic) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+    }
+
+    // Reads are bounds-checked; a truncated tail stops decoding instead of
+    // reading garbage
+    template <typename T>
+    bool Decoder::read(T& value) {
+        if (m_data.size() - m_offset < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    bool Decoder::readVarint(uint64_t& value) {
+        const char* begin = m_data.data() + m_offset;
+        const char* next = getVarint(begin, m_data.data() + m_data.size(), value);
+        if (!next) {
+            m_offset = m_data.size();
+            return false;
+        }
+        m_offset += static_cast<size_t>(next - begin);
+        return true;
+    }
+
+    bool Decoder::readString(std::string& value) {
+        uint64_t length;
+        if (!readVarint(length) || m_data.size() - m_offset < length) {
+            return false;
+        }
+        value.assign(m_data, m_offset, length);
+        m_offset += length;
+        return true;
+    }
+
+    bool Decoder::readArgument(std::string& out) {
+        uint8_t tag;
+        if (!read(tag)) {
+            return false;
+        }
+        if (tag == STRING) {
+            return readString(out);
+        }
+
+        switch (tag) {
+            case INT: {
+                uint64_t value;
+                if (!readVarint(value)) {
+                    return false;
+                }
+                out = std::to_string(unzigzag(value));
+                return true;
+            }
+            case UINT: {
+                uint64_t value;
+                if (!readVarint(value)) {
+                    return false;
+                }
+                out = std::to_string(value);
+                return true;
+            }
+            case DOUBLE: {
+                double value;
+                if (!read(value)) {
+                    return false;
+                }
+                std::ostringstream ss;
+                ss.precision(10);
+                ss << value;
+                out = ss.str();
+                return true;
+            }
+            case BOOL:
+            case CHAR: {
+                char value;
+                if (!read(value)) {
+                    return false;
+                }
+                out = tag == BOOL ? (value ? "true" : "false") : std::string(1, value);
+                return true;
+            }
+            default:
+                // Unknown tag: the value size is unknown too, so stop here
+                return false;
+        }
+    }
+
+    Decoder::Status Decoder::next(Message& out) {
+        if (!m_hasMagic) {
+            return END;
+        }
+        while (m_offset < m_data.size()) {
+            uint8_t type;
+            uint64_t id;
+            if (!read(type) || !readVarint(id)) {
+                return END;
+            }
+
+            if (type == FORMAT) {
+                Format format;
+                uint8_t level;
+                uint64_t line;
+                if (!read(level) || !readVarint(line) || !readString(format.file) || !readString(format.text)) {
+                    return END;
+                }
+                format.level = static_cast<Logger::LogLevel>(level);
+                format.line = static_cast<uint32_t>(line);
+                m_formats[id] = std::move(format);
+            } else if (type == MESSAGE) {
+                uint64_t delta;
+                uint8_t count;
+                if (!readVarint(delta) || !read(count)) {
+                    return END;
+                }
+                m_timestamp += unzigzag(delta);
+                out.timestampNs = m_timestamp;
+                out.formatId = id;
+                out.args.resize(count);
+                for (auto& arg : out.args) {
+                    if (!readArgument(arg)) {
+                        return END;
+                    }
+                }
+                auto it = m_formats.find(id);
+                out.format = it != m_formats.end() ? &it->second : nullptr;
+                return OK;
+            } else {
+                return CORRUPT;
+            }
+        }
+        return END;
+    }
+}
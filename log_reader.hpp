@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "logger.hpp"
+
+// Reading side of the binary log format described in logger.hpp, shared by
+// log_decoder and the tests.
+namespace BinaryLog {
+    const char* levelString(Logger::LogLevel level);
+
+    // Substitutes {} placeholders in order; {{ and }} are literal braces
+    std::string render(const std::string& format, const std::vector<std::string>& args);
+
+    // Local time with milliseconds, e.g. 2024-12-27 10:15:03.042
+    std::string formatTime(uint64_t timestampNs);
+
+    // Walks the records of a whole log file. FORMAT records are collected
+    // as they pass; next() hands back one MESSAGE at a time.
+    class Decoder {
+    public:
+        struct Format {
+            Logger::LogLevel level = Logger::INFO;
+            uint32_t line = 0;
+            std::string file;
+            std::string text;
+        };
+
+        struct Message {
+            int64_t timestampNs = 0;
+            uint64_t formatId = 0;
+            const Format* format = nullptr;     // nullptr if its FORMAT record is missing
+            std::vector<std::string> args;      // Arguments rendered as text
+
+            std::string text() const;
+        };
+
+        enum Status {
+            OK,         // out holds the next message
+            END,        // End of data, or a truncated tail (the process died mid-write)
+            CORRUPT     // Unknown record type
+        };
+
+        // data must outlive the decoder
+        explicit Decoder(const std::string& data);
+
+        bool hasMagic() const { return m_hasMagic; }
+        Status next(Message& out);
+
+    private:
+        template <typename T>
+        bool read(T& value);
+        bool readVarint(uint64_t& value);
+        bool readString(std::string& value);
+        bool readArgument(std::string& out);
+
+        const std::string& m_data;
+        size_t m_offset = 0;
+        bool m_hasMagic = false;
+        int64_t m_timestamp = 0;
+        std::map<uint64_t, Format> m_formats;
+    };
+}
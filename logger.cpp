@@ -1,96 +1,116 @@
 #include "logger.hpp"
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
 
 Logger::Logger() {
     std::string logFileName = generateLogFileName();
-    m_logFile.open(logFileName, std::ios::out);  
+    m_logFile.open(logFileName, std::ios::out | std::ios::binary);
     if (!m_logFile.is_open()) {
         std::cerr << "Failed to open log file: " << logFileName << std::endl;
+    } else {
+        m_logFile.write(BinaryLog::kMagic, sizeof(BinaryLog::kMagic));
     }
-    log(INFO, "Logger initialized");
+    m_buffer.resize(2 * kFlushThreshold);
+    m_writing.resize(2 * kFlushThreshold);
+    m_flushThread = std::thread(&Logger::flushLoop, this);
+    // Not LOG_INFO: that would re-enter getInstance() while it is constructing us
+    write(INFO, registerFormat(INFO, __FILE__, __LINE__, "Logger initialized"), "Logger initialized");
 }
 
 std::string Logger::generateLogFileName() {
     auto now = std::chrono::system_clock::now();
     auto now_time_t = std::chrono::system_clock::to_time_t(now);
-    
+
+    // DERIBIT_LOG_DIR overrides the built-in directory, e.g. for tests
+    const char* directory = std::getenv("DERIBIT_LOG_DIR");
     std::stringstream ss;
-    ss << "/path/to/logs/" // Replace with your desired log directory
-       << std::put_time(std::localtime(&now_time_t), "%Y%m%d_%H%M%S") 
-       << ".txt";
+    if (directory && *directory) {
+        ss << directory << '/';
+    } else {
+        ss << "/path/to/logs/"; // Replace with your desired log directory
+    }
+    ss << std::put_time(std::localtime(&now_time_t), "%Y%m%d_%H%M%S")
+       << ".bin";
     return ss.str();
 }
 
 Logger::~Logger() {
+    write(INFO, registerFormat(INFO, __FILE__, __LINE__, "Logger shutting down"), "Logger shutting down");
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_flushWakeup.notify_one();
+    if (m_flushThread.joinable()) {
+        m_flushThread.join();
+    }
+    flush();
     if (m_logFile.is_open()) {
-        log(INFO, "Logger shutting down");
         m_logFile.close();
     }
 }
 
-std::string Logger::getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto now_time_t = std::chrono::system_clock::to_time_t(now);
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&now_time_t), "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << now_ms.count();
-    return ss.str();
-}
-
-std::string Logger::getLevelString(LogLevel level) {
-    switch (level) {
-        case INFO: return "INFO";
-        case WARNING: return "WARNING";
-        case ERROR: return "ERROR";
-        case TRADE: return "TRADE";
-        case LATENCY: return "LATENCY";
-        default: return "UNKNOWN";
+char* Logger::reserve(size_t size) {
+    if (m_buffer.size() < m_bufferUsed + size) {
+        m_buffer.resize(std::max(2 * m_buffer.size(), m_bufferUsed + size));
     }
+    return m_buffer.data() + m_bufferUsed;
 }
 
-void Logger::log(LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    std::string formattedMsg = getCurrentTime() + " [" + getLevelString(level) + "] " + message;
-    
-    if (m_logFile.is_open()) {
-        m_logFile << formattedMsg << std::endl;
-        m_logFile.flush();
-    }
-    
-    // Also output to console for visibility
-    // std::cout << formattedMsg << std::endl;
-}
+uint32_t Logger::registerFormat(LogLevel level, const char* file, int line, const char* format) {
+    // Record the file name only; the directory is noise in the decoded output
+    const char* slash = std::strrchr(file, '/');
+    std::string_view fileName = slash ? slash + 1 : file;
+    std::string_view formatText = format;
 
-void Logger::logTrade(const std::string& action, const nlohmann::json& tradeData) {
-    std::stringstream ss;
-    ss << "Trade executed: " << action << " - " << tradeData.dump();
-    log(TRADE, ss.str());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint32_t id = m_nextFormatId++;
+    char* out = reserve(2 + 4 * BinaryLog::kMaxVarint + fileName.size() + formatText.size());
+    *out++ = static_cast<char>(BinaryLog::FORMAT);
+    out = BinaryLog::putVarint(out, id);
+    *out++ = static_cast<char>(level);
+    out = BinaryLog::putVarint(out, static_cast<uint64_t>(line));
+    out = BinaryLog::putVarint(out, fileName.size());
+    std::memcpy(out, fileName.data(), fileName.size());
+    out += fileName.size();
+    out = BinaryLog::putVarint(out, formatText.size());
+    std::memcpy(out, formatText.data(), formatText.size());
+    out += formatText.size();
+    m_bufferUsed = static_cast<size_t>(out - m_buffer.data());
+    return id;
 }
 
-void Logger::logError(const std::string& context, const std::string& error) {
-    std::stringstream ss;
-    ss << "[" << context << "] " << error;
-    log(ERROR, ss.str());
+void Logger::flush() {
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_writing.swap(m_buffer);
+        m_writingUsed = m_bufferUsed;
+        m_bufferUsed = 0;
+    }
+    if (m_writingUsed > 0 && m_logFile.is_open()) {
+        m_logFile.write(m_writing.data(), static_cast<std::streamsize>(m_writingUsed));
+        m_logFile.flush();
+    }
+    m_writingUsed = 0;
 }
 
-std::chrono::time_point<std::chrono::high_resolution_clock> Logger::startMeasurement(
-    const std::string& operation) {
-    log(INFO, "Starting measurement: " + operation);
-    return std::chrono::high_resolution_clock::now();
+void Logger::flushLoop() {
+    // Writers only append to memory; this thread turns the batch into one write()
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_flushWakeup.wait_for(lock, std::chrono::milliseconds(100), [this] {
+                return m_stopping || m_flushRequested || m_bufferUsed >= kFlushThreshold;
+            });
+            if (m_stopping) {
+                return;
+            }
+            m_flushRequested = false;
+        }
+        flush();
+    }
 }
-
-void Logger::endMeasurement(
-    const std::string& operation,
-    const std::chrono::time_point<std::chrono::high_resolution_clock>& startTime) {
-    
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
-    
-    std::stringstream ss;
-    ss << operation << " completed in " << duration << " microseconds (" 
-       << static_cast<double>(duration) / 1000.0 << " ms)";
-    log(LATENCY, ss.str());
-}
\ No newline at end of file
@@ -1,13 +1,87 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <chrono>
 #include <mutex>
-#include <sstream>
-#include <iomanip>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
 #include <nlohmann/json.hpp>
 
+// Severity below which log statements are compiled out entirely:
+// 0 = everything, 1 = WARNING and above, 2 = ERROR and TRADE only, 3 = nothing.
+// Set with -DLOG_COMPILE_LEVEL=<n> at configure time.
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+// On-disk layout of the binary log, read back by log_reader.hpp. The file is
+// the magic followed by records. A FORMAT record is written the first time
+// a call site logs and maps its id to level, location and format string; a
+// MESSAGE record carries only that id, a timestamp and the raw arguments.
+//
+//   FORMAT:  u8 type, var id, u8 level, var line, str file, str format
+//   MESSAGE: u8 type, var id, zigzag var ns since the previous MESSAGE
+//            (unix time for the first), u8 argc, argc x (u8 tag, value)
+//   str:     var length, bytes
+//
+// var is a LEB128 varint. Signed integers are zigzag varints, doubles are
+// 8 raw little-endian bytes, bools and chars one byte.
+namespace BinaryLog {
+    constexpr char kMagic[8] = {'D', 'R', 'B', 'L', 'O', 'G', '0', '2'};
+    constexpr size_t kMaxVarint = 10;
+
+    enum RecordType : uint8_t {
+        FORMAT = 1,
+        MESSAGE = 2
+    };
+
+    enum ArgType : uint8_t {
+        INT = 'i',
+        UINT = 'u',
+        DOUBLE = 'd',
+        BOOL = 'b',
+        CHAR = 'c',
+        STRING = 's'
+    };
+
+    inline char* putVarint(char* out, uint64_t value) {
+        while (value >= 0x80) {
+            *out++ = static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<char>(value);
+        return out;
+    }
+
+    // Decodes a varint from [in, end); returns the byte after it, or nullptr
+    // if the input ends first or the value does not fit in 64 bits
+    inline const char* getVarint(const char* in, const char* end, uint64_t& value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && in < end; shift += 7) {
+            const uint8_t byte = static_cast<uint8_t>(*in++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return in;
+            }
+        }
+        return nullptr;
+    }
+
+    inline uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    inline int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+}
+
 class Logger {
 public:
     enum LogLevel {
@@ -23,31 +97,187 @@ public:
         return instance;
     }
 
-    void log(LogLevel level, const std::string& message);
-    void logTrade(const std::string& action, const nlohmann::json& tradeData);
-    void logError(const std::string& context, const std::string& error);
-    
-    // Latency measurement methods
-    std::chrono::time_point<std::chrono::high_resolution_clock> startMeasurement(const std::string& operation);
-    void endMeasurement(const std::string& operation, 
-                        const std::chrono::time_point<std::chrono::high_resolution_clock>& startTime);
+    // LATENCY is diagnostic output like INFO; TRADE is kept as long as ERROR is
+    static constexpr int severity(LogLevel level) {
+        return level == ERROR || level == TRADE ? 2 : level == WARNING ? 1 : 0;
+    }
+    static constexpr bool isEnabled(LogLevel level) {
+        return severity(level) >= LOG_COMPILE_LEVEL;
+    }
+
+    // Called once per call site; writes the FORMAT record and returns its id
+    uint32_t registerFormat(LogLevel level, const char* file, int line, const char* format);
+
+    // Appends a MESSAGE record. Arguments are copied raw; formatting happens
+    // offline in log_decoder. The format string is only used at registration.
+    template <typename... Args>
+    void write(LogLevel level, uint32_t formatId, const char* format, const Args&... args);
+
+    // Writes buffered records to the file
+    void flush();
+
+    static int64_t elapsedMicros(const std::chrono::time_point<std::chrono::high_resolution_clock>& start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start).count();
+    }
 
 private:
     Logger();
     ~Logger();
-    std::string getCurrentTime();
     std::string generateLogFileName();
-    std::string getLevelString(LogLevel level);
+    void flushLoop();
+
+    template <typename T, typename = void>
+    struct IsString : std::false_type {};
+    template <typename T>
+    struct IsString<T, std::void_t<typename T::traits_type, decltype(std::declval<const T&>().data()),
+                                   decltype(std::declval<const T&>().size())>>
+        : std::is_same<typename T::value_type, char> {};
+
+    template <typename T>
+    static std::string_view asString(const T& value) {
+        if constexpr (std::is_array_v<T>) {
+            return std::string_view(value);
+        } else if constexpr (std::is_pointer_v<T>) {
+            return value ? std::string_view(value) : std::string_view("(null)");
+        } else {
+            return std::string_view(value.data(), value.size());
+        }
+    }
+
+    template <typename T>
+    static size_t encodedSize(const T& value);
+    template <typename T>
+    static char* encode(char* out, const T& value);
+
+    // Caller holds m_mutex. Returns room for at least size bytes at the end
+    // of m_buffer; the caller advances m_bufferUsed past what it wrote.
+    char* reserve(size_t size);
+
+    static constexpr size_t kFlushThreshold = 64 * 1024;
 
     std::ofstream m_logFile;
     std::mutex m_mutex;
+    std::condition_variable m_flushWakeup;
+    std::vector<char> m_buffer;         // Records not yet handed to the flush thread
+    size_t m_bufferUsed = 0;
+    std::vector<char> m_writing;        // Owned by whoever holds m_fileMutex
+    size_t m_writingUsed = 0;
+    std::mutex m_fileMutex;
+    uint32_t m_nextFormatId = 1;
+    int64_t m_lastTimestamp = 0;
+    bool m_flushRequested = false;
+    bool m_stopping = false;
+    std::thread m_flushThread;
 };
 
-// Helper macros for easier use
-#define LOG_INFO(msg) Logger::getInstance().log(Logger::INFO, msg)
-#define LOG_WARNING(msg) Logger::getInstance().log(Logger::WARNING, msg)
-#define LOG_ERROR(msg) Logger::getInstance().log(Logger::ERROR, msg)
-#define LOG_TRADE(action, data) Logger::getInstance().logTrade(action, data)
-#define LOG_ERROR_CTX(ctx, err) Logger::getInstance().logError(ctx, err)
-#define START_MEASUREMENT(op) auto start_##op = Logger::getInstance().startMeasurement(#op)
-#define END_MEASUREMENT(op) Logger::getInstance().endMeasurement(#op, start_##op)
\ No newline at end of file
+// Upper bound; varints are trimmed after encoding
+template <typename T>
+size_t Logger::encodedSize(const T& value) {
+    using Decayed = std::decay_t<T>;
+    if constexpr (std::is_arithmetic_v<Decayed>) {
+        return 1 + BinaryLog::kMaxVarint;
+    } else if constexpr (std::is_same_v<Decayed, const char*> || std::is_same_v<Decayed, char*> ||
+                         IsString<Decayed>::value) {
+        return 1 + BinaryLog::kMaxVarint + asString(value).size();
+    } else {
+        static_assert(std::is_arithmetic_v<Decayed>, "Log arguments must be numbers or strings");
+        return 0;
+    }
+}
+
+template <typename T>
+char* Logger::encode(char* out, const T& value) {
+    using Decayed = std::decay_t<T>;
+    if constexpr (std::is_same_v<Decayed, bool>) {
+        *out++ = static_cast<char>(BinaryLog::BOOL);
+        *out++ = value ? 1 : 0;
+        return out;
+    } else if constexpr (std::is_same_v<Decayed, char>) {
+        *out++ = static_cast<char>(BinaryLog::CHAR);
+        *out++ = value;
+        return out;
+    } else if constexpr (std::is_floating_point_v<Decayed>) {
+        double number = static_cast<double>(value);
+        *out++ = static_cast<char>(BinaryLog::DOUBLE);
+        std::memcpy(out, &number, sizeof(number));
+        return out + sizeof(number);
+    } else if constexpr (std::is_integral_v<Decayed> && std::is_signed_v<Decayed>) {
+        *out++ = static_cast<char>(BinaryLog::INT);
+        return BinaryLog::putVarint(out, BinaryLog::zigzag(static_cast<int64_t>(value)));
+    } else if constexpr (std::is_integral_v<Decayed>) {
+        *out++ = static_cast<char>(BinaryLog::UINT);
+        return BinaryLog::putVarint(out, static_cast<uint64_t>(value));
+    } else {
+        std::string_view text = asString(value);
+        *out++ = static_cast<char>(BinaryLog::STRING);
+        out = BinaryLog::putVarint(out, text.size());
+        std::memcpy(out, text.data(), text.size());
+        return out + text.size();
+    }
+}
+
+template <typename... Args>
+void Logger::write(LogLevel level, uint32_t formatId, const char*, const Args&... args) {
+    static_assert(sizeof...(Args) < 256, "Too many log arguments");
+    const int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const size_t maxSize = 2 + 2 * BinaryLog::kMaxVarint + (size_t(0) + ... + encodedSize(args));
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        char* out = reserve(maxSize);
+        *out++ = static_cast<char>(BinaryLog::MESSAGE);
+        out = BinaryLog::putVarint(out, formatId);
+        // Records can arrive slightly out of timestamp order across threads
+        out = BinaryLog::putVarint(out, BinaryLog::zigzag(timestamp - m_lastTimestamp));
+        m_lastTimestamp = timestamp;
+        *out++ = static_cast<char>(sizeof...(Args));
+        ((out = encode(out, args)), ...);
+        m_bufferUsed = static_cast<size_t>(out - m_buffer.data());
+        // Errors should reach the disk promptly; everything else is batched
+        m_flushRequested = m_flushRequested || level == ERROR;
+        wake = m_flushRequested || m_bufferUsed >= kFlushThreshold;
+    }
+    if (wake) {
+        m_flushWakeup.notify_one();
+    }
+}
+
+// Picks the format literal out of a log macro's arguments without
+// evaluating the others. The trailing token keeps the variadic part
+// non-empty, which ISO C++17 requires.
+#define LOG_FORMAT_OF(...) LOG_FORMAT_OF_(__VA_ARGS__, unused)
+#define LOG_FORMAT_OF_(format, ...) format
+
+// Arguments after the format literal fill its {} placeholders in order.
+// Below LOG_COMPILE_LEVEL the whole statement, arguments included, is
+// discarded at compile time.
+#define LOG_AT(level, ...)                                                                      \
+    do {                                                                                        \
+        if constexpr (Logger::isEnabled(level)) {                                               \
+            static const uint32_t log_format_id =                                               \
+                Logger::getInstance().registerFormat(level, __FILE__, __LINE__, LOG_FORMAT_OF(__VA_ARGS__)); \
+            Logger::getInstance().write(level, log_format_id, __VA_ARGS__);                     \
+        }                                                                                       \
+    } while (0)
+
+// Helper macros for easier use, e.g. LOG_INFO("Channel: {}", channel)
+#define LOG_INFO(...) LOG_AT(Logger::INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(Logger::WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(Logger::ERROR, __VA_ARGS__)
+#define LOG_LATENCY(...) LOG_AT(Logger::LATENCY, __VA_ARGS__)
+#define LOG_TRADE(action, ...) LOG_AT(Logger::TRADE, "Trade executed: {} - {}", action, (__VA_ARGS__).dump())
+// ctx must be a string literal, e.g. LOG_ERROR_CTX("Buy Order", "{}", e.what())
+#define LOG_ERROR_CTX(ctx, ...) LOG_AT(Logger::ERROR, "[" ctx "] " __VA_ARGS__)
+#define START_MEASUREMENT(op)                                                                   \
+    auto start_##op = [] {                                                                      \
+        LOG_INFO("Starting measurement: " #op);                                                 \
+        return std::chrono::high_resolution_clock::now();                                       \
+    }()
+#define END_MEASUREMENT(op)                                                                     \
+    do {                                                                                        \
+        const int64_t elapsed_##op = Logger::elapsedMicros(start_##op);                         \
+        LOG_LATENCY(#op " completed in {} microseconds ({} ms)", elapsed_##op, elapsed_##op / 1000.0); \
+    } while (0)
@@ -9,6 +9,12 @@
 #include "trader.hpp"
 #include "websocket.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "shm_publisher.hpp"
+#include "request_scheduler.hpp"
+#include "session_manager.hpp"
+#include "decimal.hpp"
+#include "tracing.hpp"
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -28,30 +34,76 @@ int main() {
         json config;
         configFile >> config;
 
-        std::string clientId = config["clientId"];
-        std::string clientSecret = config["clientSecret"];
-        Trader trader(clientId, clientSecret);
+        // Prometheus text on http://127.0.0.1:<metricsPort>/metrics, mirrored to /dev/shm
+        MetricsRegistry::getInstance().start(config.value("metricsPort", 9464),
+                                             config.value("metricsShm", std::string("/deribit_metrics")));
+
+        // One credit bucket per account, shared by the REST and WebSocket paths
+        auto readRateLimit = [](const json& source, RateLimitConfig rateLimit) {
+            if (source.contains("rateLimit")) {
+                const json& limits = source["rateLimit"];
+                rateLimit.maxCredits = limits.value("maxCredits", rateLimit.maxCredits);
+                rateLimit.refillPerSecond = limits.value("refillPerSecond", rateLimit.refillPerSecond);
+                rateLimit.requestCost = limits.value("requestCost", rateLimit.requestCost);
+            }
+            return rateLimit;
+        };
+        const RateLimitConfig defaultRateLimit = readRateLimit(config, RateLimitConfig{});
+
+        // Every account shares the IO threads; "accounts" lists sub-accounts,
+        // otherwise the top-level credentials form a single "main" account
+        std::vector<AccountConfig> accounts;
+        if (config.contains("accounts")) {
+            for (const json& entry : config["accounts"]) {
+                accounts.push_back({entry.at("name").get<std::string>(), entry.at("clientId").get<std::string>(),
+                                    entry.at("clientSecret").get<std::string>(),
+                                    readRateLimit(entry, defaultRateLimit)});
+            }
+        } else {
+            accounts.push_back({"main", config["clientId"], config["clientSecret"], defaultRateLimit});
+        }
+        if (accounts.empty()) {
+            LOG_ERROR("No accounts configured");
+            return 1;
+        }
+
+        // One authenticated feed for the whole host: see shm_market_data.hpp for readers
+        ShmMarketDataPublisher shmPublisher(config.value("marketDataShm", std::string("/deribit_md")));
 
         std::string deribitUri = "wss://test.deribit.com/ws/api/v2";
-        DeribitWebSocketClient wsClient(deribitUri, clientId, clientSecret);
-        
-        LOG_INFO("WebSocket client initialized");
+        SessionManager sessions(deribitUri, config.value("ioThreads", 2));
+        const bool printMarketData = config.value("printMarketData", false);
+        for (const AccountConfig& account : accounts) {
+            sessions.addAccount(account).wsClient->setPrintUpdates(printMarketData);
+        }
+
+        // Market data is the same on every connection; mirror the first account's
+        sessions.at(0).wsClient->setSharedMemoryPublisher(&shmPublisher);
+
+        LOG_INFO("WebSocket clients initialized");
+        sessions.start();
+
+        SessionManager::Session* active = &sessions.at(0);
+        Tracer::getInstance().setThreadName("main");
+        // Reads a number exactly as typed; false if it is not a plain decimal
+        auto readDecimal = [](Decimal& value) {
+            std::string text;
+            cin >> text;
+            std::from_chars_result parsed = Decimal::fromChars(text.data(), text.data() + text.size(), value);
+            return parsed.ec == std::errc() && parsed.ptr == text.data() + text.size();
+        };
 
-        // Start WebSocket client in a separate thread
-        std::thread wsThread([&]() {
-            LOG_INFO("WebSocket thread started");
-            wsClient.connect();
-            wsClient.run();
-        });
-        
         int flag = 1;
         while(flag) {
             int choice, action;
-            double price, amount; 
+            Decimal price, amount;
             string instrument_name, type, channel;
-            string order_id;
+            string order_id, account;
+            Trader& trader = *active->trader;
+            DeribitWebSocketClient& wsClient = *active->wsClient;
 
             cout << "\n===== Bitget Trading Interface =====\n";
+            cout << "Account: " << active->name << endl;
             cout << "Select action: " << endl;
             cout << "1) Buy" << endl;
             cout << "2) Sell" << endl;
@@ -61,6 +113,7 @@ int main() {
             cout << "6) Order Book" << endl;
             cout << "7) Market data streaming" << endl;
             cout << "8) Exit" << endl;
+            cout << "9) Switch account" << endl;
             cout << "Enter choice: ";
             cin >> choice;
 
@@ -73,17 +126,44 @@ int main() {
                     cout << "Enter instrument name: ";
                     cin >> instrument_name;
                     cout << "Enter amount: ";
-                    cin >> amount;
+                    if (!readDecimal(amount)) {
+                        LOG_WARNING("Invalid buy amount entered");
+                        cout << "Invalid amount" << endl;
+                        break;
+                    }
                     cout << "Enter order type: ";
                     cin >> type;
-                    
-                    endpoint = endpoint + "?instrument_name=" + instrument_name + "&amount=" + std::to_string(amount) + "&type=" + type;
-                    if(type == "limit") {
+                    if (type == "limit") {
                         cout << "Enter price: ";
-                        cin >> price;
-                        endpoint += "&price=" + std::to_string(price);
+                        if (!readDecimal(price)) {
+                            LOG_WARNING("Invalid buy price entered");
+                            cout << "Invalid price" << endl;
+                            break;
+                        }
                     }
+
                     try {
+                        const InstrumentSpec& spec = trader.instrumentSpec(instrument_name);
+                        TraceContext trace(Tracer::newTraceId());
+                        {
+                            // Never buy above the price entered, never more than the amount
+                            TRACE_SPAN("decision");
+                            amount = amount.roundToTick(spec.minTradeAmount, Decimal::Rounding::FLOOR);
+                            if (type == "limit") {
+                                price = price.roundToTick(spec.tickSize, Decimal::Rounding::FLOOR);
+                            }
+                        }
+                        {
+                            TRACE_SPAN("risk_check");
+                            if (amount.isZero()) {
+                                throw std::runtime_error("amount below minimum trade amount " + spec.minTradeAmount.toString());
+                            }
+                        }
+                        endpoint = endpoint + "?instrument_name=" + instrument_name + "&amount=" + amount.toString() + "&type=" + type;
+                        if (type == "limit") {
+                            endpoint += "&price=" + price.toString();
+                        }
+
                         START_MEASUREMENT(buy_order_placement);
                         result = trader.sendRequest(endpoint);
                         END_MEASUREMENT(buy_order_placement);
@@ -91,7 +171,7 @@ int main() {
                         LOG_TRADE("BUY", result);
                         std::cout << "Buy result: " << result.dump(2) << std::endl;
                     } catch (const std::exception& e) {
-                        LOG_ERROR_CTX("Buy Order", e.what());
+                        LOG_ERROR_CTX("Buy Order", "{}", e.what());
                         std::cerr << "Error executing buy order: " << e.what() << std::endl;
                     }
                     break;
@@ -101,17 +181,44 @@ int main() {
                     cout << "Enter instrument name: ";
                     cin >> instrument_name;
                     cout << "Enter amount: ";
-                    cin >> amount;
+                    if (!readDecimal(amount)) {
+                        LOG_WARNING("Invalid sell amount entered");
+                        cout << "Invalid amount" << endl;
+                        break;
+                    }
                     cout << "Enter order type: ";
                     cin >> type;
-                    
-                    endpoint = endpoint + "?instrument_name=" + instrument_name + "&amount=" + std::to_string(amount) + "&type=" + type;
-                    if(type == "limit") {
+                    if (type == "limit") {
                         cout << "Enter price: ";
-                        cin >> price;
-                        endpoint += "&price=" + std::to_string(price);
+                        if (!readDecimal(price)) {
+                            LOG_WARNING("Invalid sell price entered");
+                            cout << "Invalid price" << endl;
+                            break;
+                        }
                     }
+
                     try {
+                        const InstrumentSpec& spec = trader.instrumentSpec(instrument_name);
+                        TraceContext trace(Tracer::newTraceId());
+                        {
+                            // Never sell below the price entered, never more than the amount
+                            TRACE_SPAN("decision");
+                            amount = amount.roundToTick(spec.minTradeAmount, Decimal::Rounding::FLOOR);
+                            if (type == "limit") {
+                                price = price.roundToTick(spec.tickSize, Decimal::Rounding::CEIL);
+                            }
+                        }
+                        {
+                            TRACE_SPAN("risk_check");
+                            if (amount.isZero()) {
+                                throw std::runtime_error("amount below minimum trade amount " + spec.minTradeAmount.toString());
+                            }
+                        }
+                        endpoint = endpoint + "?instrument_name=" + instrument_name + "&amount=" + amount.toString() + "&type=" + type;
+                        if (type == "limit") {
+                            endpoint += "&price=" + price.toString();
+                        }
+
                         START_MEASUREMENT(sell_order_placement);
                         result = trader.sendRequest(endpoint);
                         END_MEASUREMENT(sell_order_placement);
@@ -119,7 +226,7 @@ int main() {
                         LOG_TRADE("SELL", result);
                         std::cout << "Sell result: " << result.dump(2) << std::endl;
                     } catch (const std::exception& e) {
-                        LOG_ERROR_CTX("Sell Order", e.what());
+                        LOG_ERROR_CTX("Sell Order", "{}", e.what());
                         std::cerr << "Error executing sell order: " << e.what() << std::endl;
                     }
                     break;
@@ -134,34 +241,67 @@ int main() {
                         result = trader.sendRequest(endpoint);
                         END_MEASUREMENT(cancel_order);
                         
-                        LOG_INFO("Order canceled: " + order_id);
+                        LOG_INFO("Order canceled: {}", order_id);
                         std::cout << "Cancel result: " << result.dump(2) << std::endl;
                     } catch (const std::exception& e) {
-                        LOG_ERROR_CTX("Cancel Order", e.what());
+                        LOG_ERROR_CTX("Cancel Order", "{}", e.what());
                         std::cerr << "Error canceling order: " << e.what() << std::endl;
                     }
                     break;
                     
                 case 4: // Modify
-                    endpoint = "private/edit";
                     cout << "Enter order ID: ";
                     cin >> order_id;
+                    cout << "Enter instrument name: ";
+                    cin >> instrument_name;
                     cout << "Enter new amount (or 0 to keep current): ";
-                    cin >> amount;
+                    if (!readDecimal(amount)) {
+                        LOG_WARNING("Invalid modify amount entered");
+                        cout << "Invalid amount" << endl;
+                        break;
+                    }
                     cout << "Enter new price (or 0 to keep current): ";
-                    cin >> price;
-
-                    endpoint = endpoint + "?order_id=" + order_id + "&amount=" + std::to_string(amount) + "&price=" + std::to_string(price);
+                    if (!readDecimal(price)) {
+                        LOG_WARNING("Invalid modify price entered");
+                        cout << "Invalid price" << endl;
+                        break;
+                    }
 
                     try {
+                        const InstrumentSpec& spec = trader.instrumentSpec(instrument_name);
+                        TraceContext trace(Tracer::newTraceId());
+                        // Zero means "keep" only when typed; a nonzero amount
+                        // rounding to zero would otherwise silently keep the old one
+                        const bool keepAmount = amount.isZero();
+                        {
+                            TRACE_SPAN("decision");
+                            amount = amount.roundToTick(spec.minTradeAmount, Decimal::Rounding::FLOOR);
+                            price = price.roundToTick(spec.tickSize, Decimal::Rounding::NEAREST);
+                        }
+                        {
+                            TRACE_SPAN("risk_check");
+                            if (!keepAmount && amount.isZero()) {
+                                throw std::runtime_error("amount below minimum trade amount " + spec.minTradeAmount.toString());
+                            }
+                        }
+
+                        // Sent over the WebSocket; the result arrives asynchronously. If an
+                        // edit for this order is still unacknowledged, this one is merged
+                        // into the next edit instead of being sent separately.
                         START_MEASUREMENT(modify_order);
-                        result = trader.sendRequest(endpoint);
+                        EditCoalescer::Result edit = wsClient.amendOrder(order_id, amount, price);
                         END_MEASUREMENT(modify_order);
-                        
-                        LOG_INFO("Order modified: " + order_id);
-                        std::cout << "Modify result: " << result.dump(2) << std::endl;
+
+                        if (edit == EditCoalescer::Result::SENT) {
+                            LOG_INFO("Order modification sent: {}", order_id);
+                            std::cout << "Modify request sent for order " << order_id << std::endl;
+                        } else {
+                            LOG_INFO("Order modification queued behind in-flight edit: {}", order_id);
+                            std::cout << "Previous edit still in flight; order " << order_id
+                                      << " will be updated to the latest values on its ack" << std::endl;
+                        }
                     } catch (const std::exception& e) {
-                        LOG_ERROR_CTX("Modify Order", e.what());
+                        LOG_ERROR_CTX("Modify Order", "{}", e.what());
                         std::cerr << "Error modifying order: " << e.what() << std::endl;
                     }
                     break;
@@ -179,7 +319,7 @@ int main() {
                         
                         std::cout << "Positions: " << result.dump(2) << std::endl;
                     } catch (const std::exception& e) {
-                        LOG_ERROR_CTX("View Positions", e.what());
+                        LOG_ERROR_CTX("View Positions", "{}", e.what());
                         std::cerr << "Error fetching positions: " << e.what() << std::endl;
                     }
                     break;
@@ -196,7 +336,7 @@ int main() {
                         
                         std::cout << "Order Book: " << result.dump(2) << std::endl;
                     } catch (const std::exception& e) {
-                        LOG_ERROR_CTX("Order Book", e.what());
+                        LOG_ERROR_CTX("Order Book", "{}", e.what());
                         std::cerr << "Error fetching order book: " << e.what() << std::endl;
                     }
                     break;
@@ -214,29 +354,29 @@ int main() {
 
                     
                     if (action < 1 || action > 4) {
-                        LOG_WARNING("Invalid market data action selected: " + std::to_string(action));
+                        LOG_WARNING("Invalid market data action selected: {}", action);
                         cout << "Invalid choice" << endl;
                         break;
                     }
                     switch (action) {
                         case 1: // Public Subscribe
                             wsClient.publicSubscribe({channel});
-                            LOG_INFO("Subscribed to public channel: " + channel);
+                            LOG_INFO("Subscribed to public channel: {}", channel);
                             break;
                             
                         case 2: // Private Subscribe
                             wsClient.privateSubscribe({channel});
-                            LOG_INFO("Subscribed to private channel: " + channel);
+                            LOG_INFO("Subscribed to private channel: {}", channel);
                             break;
                             
                         case 3: // Public Unsubscribe
                             wsClient.publicUnsubscribe({channel});
-                            LOG_INFO("Unsubscribed from public channel: " + channel);
+                            LOG_INFO("Unsubscribed from public channel: {}", channel);
                             break;
                             
                         case 4: // Private Unsubscribe
                             wsClient.privateUnsubscribe({channel});
-                            LOG_INFO("Unsubscribed from private channel: " + channel);
+                            LOG_INFO("Unsubscribed from private channel: {}", channel);
                             break;
                     }
                     break;
@@ -246,24 +386,39 @@ int main() {
                     cout << "Exiting program." << endl;
                     break;
                     
+                case 9: // Switch account
+                    for (size_t i = 0; i < sessions.size(); ++i) {
+                        cout << "  " << sessions.at(i).name << endl;
+                    }
+                    cout << "Enter account name: ";
+                    cin >> account;
+                    if (SessionManager::Session* session = sessions.find(account)) {
+                        active = session;
+                        LOG_INFO("Switched to account {}", account);
+                    } else {
+                        LOG_WARNING("Unknown account selected: {}", account);
+                        cout << "Unknown account" << endl;
+                    }
+                    break;
+
                 default:
-                    LOG_WARNING("Invalid menu option selected: " + std::to_string(choice));
+                    LOG_WARNING("Invalid menu option selected: {}", choice);
                     cout << "Invalid choice" << endl;
                     break;
             }
         }
         
-        LOG_INFO("Waiting for WebSocket thread to terminate");
-        if (wsThread.joinable()) {
-            wsThread.join();
-        }
+        LOG_INFO("Stopping IO threads");
+        sessions.stop();
+        Tracer::getInstance().exportChromeTrace(config.value("traceFile", std::string("/path/to/logs/trace.json")));
     } catch (const std::exception& e) {
-        LOG_ERROR(std::string("Main: ") + e.what());
+        LOG_ERROR("Main: {}", e.what());
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
     
     LOG_INFO("Application shutting down");
+    MetricsRegistry::getInstance().stop();
     // Clean up CURL global resources
     curl_global_cleanup();
     return 0;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+// Latest top-of-book and ticker values for one instrument. Fields that a
+// channel does not carry keep their previous value.
+struct MarketState {
+    double bestBidPrice = 0.0;
+    double bestBidAmount = 0.0;
+    double bestAskPrice = 0.0;
+    double bestAskAmount = 0.0;
+    double lastPrice = 0.0;
+    double markPrice = 0.0;
+    double indexPrice = 0.0;
+    uint64_t timestamp = 0; // Exchange timestamp in milliseconds
+};
+
+// Fixed-size decoded event published on the EventBus. Strings are
+// truncated to fit so the event stays trivially copyable.
+struct MarketEvent {
+    enum Type : uint8_t {
+        TRADE,
+        BOOK_CHANGE,
+        ORDER_UPDATE
+    };
+
+    enum Side : uint8_t {
+        BUY,    // Bid side for book changes
+        SELL    // Ask side for book changes
+    };
+
+    enum BookAction : uint8_t {
+        NEW,
+        CHANGE,
+        DELETE,
+        SNAPSHOT    // Level from a grouped (non-incremental) book
+    };
+
+    Type type = TRADE;
+    Side side = BUY;
+    BookAction action = NEW;
+    char instrument[32] = {};
+    char id[32] = {};           // trade_id or order_id
+    char orderState[16] = {};   // open, filled, cancelled, ...
+    double price = 0.0;
+    double amount = 0.0;
+    double filledAmount = 0.0;
+    uint64_t changeId = 0;
+    uint64_t timestamp = 0;     // Exchange timestamp in milliseconds
+};
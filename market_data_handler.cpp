@@ -0,0 +1,248 @@
+#include "market_data_handler.hpp"
+#include "logger.hpp"
+#include "shm_publisher.hpp"
+#include "tracing.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+MarketDataHandler::MarketDataHandler(BookSynchronizer::RequestSnapshot requestSnapshot, const std::string& labels,
+                                     std::chrono::milliseconds minSnapshotInterval)
+    : m_bookSync(std::move(requestSnapshot), labels, minSnapshotInterval) {
+}
+
+void MarketDataHandler::onNotification(const arena_json& msg) {
+    if (msg["method"] == "subscription") {
+        START_MEASUREMENT(subscription_processing);
+        handleSubscriptionData(msg);
+        END_MEASUREMENT(subscription_processing);
+    }
+}
+
+void MarketDataHandler::reset() {
+    m_bookSync.reset();
+}
+
+void MarketDataHandler::handleSubscriptionData(const arena_json& msg) {
+    if (msg.contains("params") && msg["params"].contains("data")) {
+        const arena_json& market_data = msg["params"]["data"];
+        LOG_INFO("Market Update received");
+        if (msg["params"].contains("channel")) {
+            const auto& channelName = msg["params"]["channel"].get_ref<const arena_json::string_t&>();
+            const std::string_view channel(channelName.data(), channelName.size());
+            LOG_INFO("Channel: {}", channel);
+            updateOrderBook(channel, market_data);
+            updateMarketState(channel, market_data);
+            updateOptionChains(channel, market_data);
+            publishEvents(channel, market_data);
+        }
+
+        if (m_printUpdates) {
+            std::cout << "Market Update: " << market_data.dump(4) << std::endl;
+        }
+    }
+}
+
+void MarketDataHandler::updateMarketState(std::string_view channel, const arena_json& data) {
+    if (!data.is_object() || !data.contains("instrument_name")) {
+        return;
+    }
+    const bool isTicker = channel.compare(0, 7, "ticker.") == 0;
+    const bool isQuote = channel.compare(0, 6, "quote.") == 0;
+    const bool isBook = channel.compare(0, 5, "book.") == 0;
+    if (!isTicker && !isQuote && !isBook) {
+        return;
+    }
+
+    const auto& instrument = data["instrument_name"].get_ref<const arena_json::string_t&>();
+    m_marketState.update(std::string_view(instrument.data(), instrument.size()), [&](MarketState& state) {
+        auto number = [&](const char* key, double& field) {
+            auto it = data.find(key);
+            if (it != data.end() && it->is_number()) {
+                field = it->get<double>();
+            }
+        };
+
+        if (isBook) {
+            // Top of the maintained book; left as is while the book is stale
+            if (const OrderBook* book = m_bookSync.book(channel)) {
+                Decimal price, amount;
+                if (book->bestBid(price, amount)) {
+                    state.bestBidPrice = price.toDouble();
+                    state.bestBidAmount = amount.toDouble();
+                }
+                if (book->bestAsk(price, amount)) {
+                    state.bestAskPrice = price.toDouble();
+                    state.bestAskAmount = amount.toDouble();
+                }
+            }
+        } else {
+            number("best_bid_price", state.bestBidPrice);
+            number("best_bid_amount", state.bestBidAmount);
+            number("best_ask_price", state.bestAskPrice);
+            number("best_ask_amount", state.bestAskAmount);
+            number("last_price", state.lastPrice);
+            number("mark_price", state.markPrice);
+            number("index_price", state.indexPrice);
+        }
+
+        auto ts = data.find("timestamp");
+        if (ts != data.end() && ts->is_number()) {
+            state.timestamp = ts->get<uint64_t>();
+        }
+
+        if (m_shmPublisher) {
+            m_shmPublisher->publishState(std::string_view(instrument.data(), instrument.size()), state);
+        }
+    });
+}
+
+void MarketDataHandler::updateOptionChains(std::string_view channel, const arena_json& data) {
+    if (channel.compare(0, 7, "ticker.") != 0 || !data.is_object() || !data.contains("instrument_name")) {
+        return;
+    }
+    auto number = [&](const char* key) {
+        auto it = data.find(key);
+        return it != data.end() && it->is_number() ? it->get<double>() : 0.0;
+    };
+    auto ts = data.find("timestamp");
+    const uint64_t timestamp = ts != data.end() && ts->is_number() ? ts->get<uint64_t>() : 0;
+
+    const auto& name = data["instrument_name"].get_ref<const arena_json::string_t&>();
+    const std::string_view instrument(name.data(), name.size());
+    if (!m_optionChains.onOptionTicker(instrument, number("best_bid_price"), number("best_ask_price"),
+                                       number("mark_price"), number("underlying_price"),
+                                       number("index_price"), timestamp)) {
+        // Futures and perpetuals carry the index the option forwards move with
+        m_optionChains.onIndexPrice(instrument.substr(0, instrument.find('-')), number("index_price"), timestamp);
+    }
+    m_optionChains.recompute();
+}
+
+void MarketDataHandler::updateOrderBook(std::string_view channel, const arena_json& data) {
+    if (channel.compare(0, 5, "book.") == 0) {
+        m_bookSync.onUpdate(channel, data);
+    }
+}
+
+void MarketDataHandler::onBookSnapshot(const std::string& channel, const arena_json& msg) {
+    auto result = msg.find("result");
+    if (msg.contains("error") || result == msg.end() || !result->is_object()) {
+        LOG_WARNING("Snapshot request for book {} failed", channel);
+        m_bookSync.onSnapshotFailed(channel);
+        return;
+    }
+    m_bookSync.onSnapshot(channel, *result);
+}
+
+void MarketDataHandler::publishEvents(std::string_view channel, const arena_json& data) {
+    auto copyString = [](const arena_json& obj, const char* key, char* dest, size_t size) {
+        auto it = obj.find(key);
+        if (it != obj.end() && it->is_string()) {
+            const auto& value = it->get_ref<const arena_json::string_t&>();
+            size_t len = std::min(value.size(), size - 1);
+            std::memcpy(dest, value.data(), len);
+            dest[len] = '\0';
+        }
+    };
+    auto number = [](const arena_json& obj, const char* key, auto& field) {
+        auto it = obj.find(key);
+        if (it != obj.end() && it->is_number()) {
+            field = it->get<std::decay_t<decltype(field)>>();
+        }
+    };
+
+    if (channel.compare(0, 7, "trades.") == 0 || channel.compare(0, 12, "user.trades.") == 0) {
+        const bool isPublicTape = channel.compare(0, 7, "trades.") == 0;
+        for (const auto& trade : data) {
+            MarketEvent event;
+            event.type = MarketEvent::TRADE;
+            copyString(trade, "instrument_name", event.instrument, sizeof(event.instrument));
+            copyString(trade, "trade_id", event.id, sizeof(event.id));
+            number(trade, "price", event.price);
+            number(trade, "amount", event.amount);
+            number(trade, "timestamp", event.timestamp);
+            event.side = trade.value("direction", "") == "sell" ? MarketEvent::SELL : MarketEvent::BUY;
+            m_eventBus.publish(event);
+
+            if (!isPublicTape) {
+                auto orderId = trade.find("order_id");
+                if (orderId != trade.end() && orderId->is_string()) {
+                    const auto& id = orderId->get_ref<const arena_json::string_t&>();
+                    Tracer::getInstance().onFill(std::string_view(id.data(), id.size()), trade.value("state", "") != "open");
+                }
+            }
+
+            if (isPublicTape) {
+                m_tradeAggregator.onTrade(event.instrument, event.timestamp, event.price, event.amount);
+            }
+
+            if (m_shmPublisher) {
+                ShmTrade print;
+                print.price = event.price;
+                print.amount = event.amount;
+                print.timestamp = event.timestamp;
+                print.side = event.side;
+                std::memcpy(print.tradeId, event.id, sizeof(print.tradeId));
+                m_shmPublisher->publishTrade(event.instrument, print);
+            }
+        }
+    } else if (channel.compare(0, 5, "book.") == 0) {
+        MarketEvent event;
+        event.type = MarketEvent::BOOK_CHANGE;
+        copyString(data, "instrument_name", event.instrument, sizeof(event.instrument));
+        number(data, "change_id", event.changeId);
+        number(data, "timestamp", event.timestamp);
+
+        auto publishSide = [&](const char* key, MarketEvent::Side side) {
+            auto levels = data.find(key);
+            if (levels == data.end()) {
+                return;
+            }
+            event.side = side;
+            for (const auto& level : *levels) {
+                if (level.size() == 3) {
+                    // Incremental: [action, price, amount]
+                    const auto& action = level[0].get_ref<const arena_json::string_t&>();
+                    event.action = action == "new" ? MarketEvent::NEW
+                                 : action == "delete" ? MarketEvent::DELETE
+                                 : MarketEvent::CHANGE;
+                    event.price = level[1].get<double>();
+                    event.amount = level[2].get<double>();
+                } else if (level.size() == 2) {
+                    // Grouped: [price, amount]
+                    event.action = MarketEvent::SNAPSHOT;
+                    event.price = level[0].get<double>();
+                    event.amount = level[1].get<double>();
+                } else {
+                    continue;
+                }
+                m_eventBus.publish(event);
+            }
+        };
+        publishSide("bids", MarketEvent::BUY);
+        publishSide("asks", MarketEvent::SELL);
+    } else if (channel.compare(0, 12, "user.orders.") == 0) {
+        auto publishOrder = [&](const arena_json& order) {
+            MarketEvent event;
+            event.type = MarketEvent::ORDER_UPDATE;
+            copyString(order, "instrument_name", event.instrument, sizeof(event.instrument));
+            copyString(order, "order_id", event.id, sizeof(event.id));
+            copyString(order, "order_state", event.orderState, sizeof(event.orderState));
+            number(order, "price", event.price);
+            number(order, "amount", event.amount);
+            number(order, "filled_amount", event.filledAmount);
+            number(order, "last_update_timestamp", event.timestamp);
+            event.side = order.value("direction", "") == "sell" ? MarketEvent::SELL : MarketEvent::BUY;
+            m_eventBus.publish(event);
+        };
+        // Raw order channels deliver one order, grouped ones an array
+        if (data.is_array()) {
+            for (const auto& order : data) {
+                publishOrder(order);
+            }
+        } else {
+            publishOrder(data);
+        }
+    }
+}
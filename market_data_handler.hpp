@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include "book_sync.hpp"
+#include "conflation_queue.hpp"
+#include "event_bus.hpp"
+#include "message_arena.hpp"
+#include "option_chain.hpp"
+#include "trade_aggregator.hpp"
+
+class ShmMarketDataPublisher;
+
+// Decodes subscription notifications of one connection into the market
+// data consumers: sequence-checked books, conflated top-of-book state,
+// option analytics, the event bus, trade bars, fill traces and the
+// shared-memory feed. Everything it builds per frame lives in the frame's
+// MessageArena, so steady-state handling does not touch the heap.
+// IO thread only; the consumers' own read sides are thread-safe as
+// documented on them.
+class MarketDataHandler {
+public:
+    MarketDataHandler(BookSynchronizer::RequestSnapshot requestSnapshot, const std::string& labels,
+                      std::chrono::milliseconds minSnapshotInterval = BookSynchronizer::kMinSnapshotInterval);
+
+    // A parsed inbound frame with a "method"; only "subscription"
+    // notifications are handled
+    void onNotification(const arena_json& msg);
+    // Reply to a get_order_book request made for the channel's resync
+    void onBookSnapshot(const std::string& channel, const arena_json& msg);
+    // Connection lost
+    void reset();
+
+    // Echo every update to stdout as indented JSON. Off by default: the
+    // dump allocates on the heap for every frame.
+    void setPrintUpdates(bool print) { m_printUpdates = print; }
+    void setSharedMemoryPublisher(ShmMarketDataPublisher* publisher) { m_shmPublisher = publisher; }
+
+    ConflationQueue& marketState() { return m_marketState; }
+    EventBus& events() { return m_eventBus; }
+    TradeAggregator& tradeAggregates() { return m_tradeAggregator; }
+    const OptionChainEngine& optionChains() const { return m_optionChains; }
+    const BookSynchronizer& books() const { return m_bookSync; }
+
+private:
+    void handleSubscriptionData(const arena_json& msg);
+    void updateMarketState(std::string_view channel, const arena_json& data);
+    void updateOptionChains(std::string_view channel, const arena_json& data);
+    void updateOrderBook(std::string_view channel, const arena_json& data);
+    void publishEvents(std::string_view channel, const arena_json& data);
+
+    ConflationQueue m_marketState;
+    EventBus m_eventBus;
+    TradeAggregator m_tradeAggregator;
+    OptionChainEngine m_optionChains;
+    BookSynchronizer m_bookSync;
+    ShmMarketDataPublisher* m_shmPublisher = nullptr;
+    bool m_printUpdates = false;
+};
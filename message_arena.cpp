@@ -0,0 +1,64 @@
+#include "message_arena.hpp"
+#include "logger.hpp"
+#include <cstdlib>
+#include <new>
+
+thread_local MessageArena* MessageArena::t_arena = nullptr;
+thread_local MessageArena* MessageArena::t_routed = nullptr;
+
+MessageArena::MessageArena() {
+    allocateBuffer(kInitialCapacity);
+    t_arena = this;
+}
+
+MessageArena::~MessageArena() {
+    t_arena = nullptr;
+}
+
+void MessageArena::allocateBuffer(size_t capacity) {
+    m_resource.reset();
+    m_buffer.reset(new std::byte[capacity]);
+    m_capacity = capacity;
+    m_resource = std::make_unique<std::pmr::monotonic_buffer_resource>(m_buffer.get(), m_capacity, &m_upstream);
+}
+
+void MessageArena::reset() {
+    if (!m_upstream.used) {
+        m_resource->release();
+        return;
+    }
+
+    // The last frame spilled onto the heap: grow so the next one like it fits
+    ++m_overflows;
+    m_upstream.used = false;
+    allocateBuffer(m_capacity * 2);
+    LOG_WARNING("Message arena overflowed, capacity raised to {} bytes", m_capacity);
+}
+
+void* MessageArena::OverflowResource::do_allocate(size_t bytes, size_t alignment) {
+    used = true;
+    if (alignment < alignof(std::max_align_t)) {
+        alignment = alignof(std::max_align_t);
+    }
+    const size_t header = headerSize(alignment);
+    auto raw = static_cast<std::byte*>(std::aligned_alloc(alignment, header + (bytes + alignment - 1) / alignment * alignment));
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    m_chunks = new (raw) Chunk{m_chunks, raw + header, raw + header + bytes};
+    return raw + header;
+}
+
+void MessageArena::OverflowResource::do_deallocate(void* p, size_t, size_t alignment) {
+    if (alignment < alignof(std::max_align_t)) {
+        alignment = alignof(std::max_align_t);
+    }
+    auto raw = static_cast<std::byte*>(p) - headerSize(alignment);
+    for (Chunk** link = &m_chunks; *link; link = &(*link)->next) {
+        if (reinterpret_cast<std::byte*>(*link) == raw) {
+            *link = (*link)->next;
+            break;
+        }
+    }
+    std::free(raw);
+}
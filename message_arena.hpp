@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Per-thread monotonic arena for everything built while handling one
+// inbound frame (the parsed DOM and its strings). Allocation is a pointer
+// bump, deallocation is a no-op and reset() rewinds the arena once the frame
+// has been handled. If a frame outgrows the buffer the overflow comes from
+// the heap and the buffer is enlarged at the next reset, so steady-state
+// message handling does not touch the global allocator.
+class MessageArena {
+public:
+    static MessageArena& forThisThread() {
+        thread_local MessageArena arena;
+        return arena;
+    }
+
+    // Arena of the calling thread if it has one, without creating it
+    static MessageArena* existingForThisThread() { return t_arena; }
+
+    // Arena that global operator new is currently routed to, if any
+    static MessageArena* routedForThisThread() { return t_routed; }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        return m_resource->allocate(bytes, alignment);
+    }
+
+    void reset();
+
+    // True for the buffer and for overflow chunks handed out since the last
+    // reset, so frees of either are left to reset()
+    bool owns(const void* p) const {
+        auto byte = static_cast<const std::byte*>(p);
+        return (byte >= m_buffer.get() && byte < m_buffer.get() + m_capacity) || m_upstream.owns(byte);
+    }
+
+    size_t capacity() const { return m_capacity; }
+    uint64_t overflows() const { return m_overflows; }
+
+    // Rewinds the arena when the current frame goes out of scope
+    class Scope {
+    public:
+        Scope() : m_arena(forThisThread()) {}
+        ~Scope() { m_arena.reset(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        MessageArena& m_arena;
+    };
+
+    // Serves global operator new on this thread from the arena while alive.
+    // nlohmann's parser keeps its lexer buffer and parse stacks in
+    // std::allocator containers, so this is how those temporaries are kept
+    // off the heap. Only wrap code that releases what it allocates before
+    // the enclosing Scope ends.
+    class RouteGlobalAllocations {
+    public:
+        RouteGlobalAllocations() : m_previous(t_routed) { t_routed = &forThisThread(); }
+        ~RouteGlobalAllocations() { t_routed = m_previous; }
+        RouteGlobalAllocations(const RouteGlobalAllocations&) = delete;
+        RouteGlobalAllocations& operator=(const RouteGlobalAllocations&) = delete;
+
+    private:
+        MessageArena* m_previous;
+    };
+
+private:
+    static constexpr size_t kInitialCapacity = 256 * 1024;
+
+    static thread_local MessageArena* t_arena;
+    static thread_local MessageArena* t_routed;
+
+    MessageArena();
+    ~MessageArena();
+    void allocateBuffer(size_t capacity);
+
+    // Heap upstream that records whether the arena spilled over. Uses malloc
+    // directly so it stays valid while operator new is routed to the arena.
+    // Each chunk starts with a header linking it into a list, so routed
+    // allocations served from a chunk are recognised by owns() without
+    // allocating any bookkeeping.
+    class OverflowResource : public std::pmr::memory_resource {
+    public:
+        bool used = false;
+
+        bool owns(const std::byte* p) const {
+            for (const Chunk* chunk = m_chunks; chunk; chunk = chunk->next) {
+                if (p >= chunk->begin && p < chunk->end) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        struct Chunk {
+            Chunk* next;
+            std::byte* begin;
+            std::byte* end;
+        };
+
+        static size_t headerSize(size_t alignment) {
+            return (sizeof(Chunk) + alignment - 1) / alignment * alignment;
+        }
+
+        Chunk* m_chunks = nullptr;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::unique_ptr<std::byte[]> m_buffer;
+    size_t m_capacity = 0;
+    uint64_t m_overflows = 0;
+    OverflowResource m_upstream;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> m_resource;
+};
+
+// Stateless allocator drawing from the calling thread's MessageArena
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(MessageArena::forThisThread().allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) noexcept {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>&) const noexcept { return false; }
+};
+
+using arena_string = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+// JSON DOM whose nodes, arrays, objects and strings all live in the arena.
+// Values must not outlive the MessageArena::Scope they were parsed in.
+using arena_json = nlohmann::basic_json<std::map, std::vector, arena_string, bool,
+                                        std::int64_t, std::uint64_t, double, ArenaAllocator>;
+
+// DOM of one inbound frame. Parsing and teardown both run with global
+// allocations routed to the arena (nlohmann also tears trees down through
+// a std::vector), so neither touches the heap. Create inside a
+// MessageArena::Scope.
+class ArenaDocument {
+public:
+    explicit ArenaDocument(const std::string& payload) {
+        MessageArena::RouteGlobalAllocations route;
+        m_json = arena_json::parse(payload);
+    }
+
+    ~ArenaDocument() {
+        MessageArena::RouteGlobalAllocations route;
+        m_json = nullptr;
+    }
+
+    ArenaDocument(const ArenaDocument&) = delete;
+    ArenaDocument& operator=(const ArenaDocument&) = delete;
+
+    const arena_json& json() const { return m_json; }
+
+private:
+    arena_json m_json;
+};
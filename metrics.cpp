@@ -0,0 +1,353 @@
+#include "metrics.hpp"
+#include "logger.hpp"
+#include <boost/asio.hpp>
+#include <sstream>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for (const Shard& shard : m_shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t MetricCounter::shardIndex() {
+    static std::atomic<size_t> nextShard{0};
+    thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+}
+
+size_t LatencyHistogram::bucketFor(uint64_t value) {
+    if (value < 4) {
+        return static_cast<size_t>(value);
+    }
+    size_t exponent = 63 - __builtin_clzll(value);
+    size_t subBucket = (value >> (exponent - 2)) & 3;
+    return (exponent - 1) * 4 + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    size_t exponent = bucket / 4 + 1;
+    uint64_t subBucket = bucket % 4;
+    return ((4 + subBucket + 1) << (exponent - 2)) - 1;
+}
+
+uint64_t LatencyHistogram::countAtMost(uint64_t bound) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBuckets && bucketUpperBound(i) <= bound; ++i) {
+        total += m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(kBuckets - 1);
+}
+
+// Minimal HTTP/1.0 responder: every request gets the current metrics text
+struct MetricsRegistry::HttpServer {
+    HttpServer(MetricsRegistry& registry, unsigned short port)
+        : registry(registry),
+          acceptor(io, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), port)) {}
+
+    void accept() {
+        auto socket = std::make_shared<boost::asio::ip::tcp::socket>(io);
+        acceptor.async_accept(*socket, [this, socket](const boost::system::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            auto request = std::make_shared<boost::asio::streambuf>();
+            boost::asio::async_read_until(*socket, *request, "\r\n\r\n",
+                [this, socket, request](const boost::system::error_code& readEc, size_t) {
+                    if (readEc) {
+                        return;
+                    }
+                    std::string body = registry.renderPrometheus();
+                    auto response = std::make_shared<std::string>(
+                        "HTTP/1.0 200 OK\r\n"
+                        "Content-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                        "Connection: close\r\n\r\n" + body);
+                    boost::asio::async_write(*socket, boost::asio::buffer(*response),
+                        [socket, response](const boost::system::error_code&, size_t) {
+                            boost::system::error_code ignored;
+                            socket->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+                        });
+                });
+            accept();
+        });
+    }
+
+    MetricsRegistry& registry;
+    boost::asio::io_context io;
+    boost::asio::ip::tcp::acceptor acceptor;
+};
+
+MetricsRegistry::MetricsRegistry() = default;
+
+MetricsRegistry::~MetricsRegistry() {
+    stop();
+}
+
+std::string MetricsRegistry::label(std::string_view name, std::string_view value) {
+    std::string result(name);
+    result += "=\"";
+    for (char c : value) {
+        switch (c) {
+            case '\\':
+                result += "\\\\";
+                break;
+            case '"':
+                result += "\\\"";
+                break;
+            case '\n':
+                result += "\\n";
+                break;
+            default:
+                result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+std::string MetricsRegistry::fullName(const std::string& name, const std::string& labels) {
+    return labels.empty() ? name : name + "{" + labels + "}";
+}
+
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Family<MetricCounter>& family = m_counters[name];
+    auto it = family.byLabels.find(labels);
+    if (it != family.byLabels.end()) {
+        return *it->second;
+    }
+    MetricCounter& metric = family.metrics.emplace_back();
+    family.byLabels.emplace(labels, &metric);
+    return metric;
+}
+
+MetricGauge& MetricsRegistry::gauge(const std::string& name, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Family<MetricGauge>& family = m_gauges[name];
+    auto it = family.byLabels.find(labels);
+    if (it != family.byLabels.end()) {
+        return *it->second;
+    }
+    MetricGauge& metric = family.metrics.emplace_back();
+    family.byLabels.emplace(labels, &metric);
+    return metric;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Family<LatencyHistogram>& family = m_histograms[name];
+    auto it = family.byLabels.find(labels);
+    if (it != family.byLabels.end()) {
+        return *it->second;
+    }
+    LatencyHistogram& metric = family.metrics.emplace_back();
+    family.byLabels.emplace(labels, &metric);
+    return metric;
+}
+
+std::string MetricsRegistry::renderPrometheus() {
+    static const double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::stringstream ss;
+
+    for (const auto& family : m_counters) {
+        ss << "# TYPE " << family.first << " counter\n";
+        for (const auto& metric : family.second.byLabels) {
+            ss << fullName(family.first, metric.first) << ' ' << metric.second->value() << '\n';
+        }
+
+        std::string rateName = family.first;
+        if (rateName.size() > 6 && rateName.compare(rateName.size() - 6, 6, "_total") == 0) {
+            rateName.resize(rateName.size() - 6);
+        }
+        rateName += "_per_second";
+        ss << "# TYPE " << rateName << " gauge\n";
+        for (const auto& metric : family.second.byLabels) {
+            auto rate = m_rates.find(fullName(family.first, metric.first));
+            ss << fullName(rateName, metric.first) << ' '
+               << (rate != m_rates.end() ? rate->second.perSecond : 0.0) << '\n';
+        }
+    }
+
+    for (const auto& family : m_gauges) {
+        ss << "# TYPE " << family.first << " gauge\n";
+        for (const auto& metric : family.second.byLabels) {
+            ss << fullName(family.first, metric.first) << ' ' << metric.second->value() << '\n';
+        }
+    }
+
+    for (const auto& family : m_histograms) {
+        ss << "# TYPE " << family.first << " histogram\n";
+        for (const auto& metric : family.second.byLabels) {
+            const std::string prefix = family.first + "_bucket{" + metric.first + (metric.first.empty() ? "" : ",");
+            for (int bits = 1; bits <= LatencyHistogram::kBucketBits; ++bits) {
+                const uint64_t bound = (uint64_t(1) << bits) - 1;
+                ss << prefix << "le=\"" << bound << "\"} " << metric.second->countAtMost(bound) << '\n';
+            }
+            ss << prefix << "le=\"+Inf\"} " << metric.second->count() << '\n';
+            ss << fullName(family.first + "_sum", metric.first) << ' ' << metric.second->sum() << '\n';
+            ss << fullName(family.first + "_count", metric.first) << ' ' << metric.second->count() << '\n';
+        }
+        // Exact-rank percentiles from the full bucket resolution
+        ss << "# TYPE " << family.first << "_quantile gauge\n";
+        for (const auto& metric : family.second.byLabels) {
+            const std::string separator = metric.first.empty() ? "" : ",";
+            for (double q : kQuantiles) {
+                ss << family.first << "_quantile{" << metric.first << separator << "quantile=\"" << q << "\"} "
+                   << metric.second->percentile(q) << '\n';
+            }
+        }
+    }
+    return ss.str();
+}
+
+void MetricsRegistry::start(unsigned short httpPort, const std::string& shmName) {
+    if (m_running.exchange(true)) {
+        return;
+    }
+
+    m_shmName = shmName;
+    int fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd >= 0 && ftruncate(fd, sizeof(MetricsSharedBlock)) == 0) {
+        void* mapping = mmap(nullptr, sizeof(MetricsSharedBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED) {
+            m_sharedBlock = new (mapping) MetricsSharedBlock{MetricsSharedBlock::kMagic, {}};
+            LOG_INFO("Metrics mirrored to shared memory {}", shmName);
+        }
+    }
+    // close() may overwrite the errno of the step that failed
+    const int error = errno;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!m_sharedBlock) {
+        LOG_ERROR_CTX("Metrics", "Failed to map shared memory {}: {}", shmName, std::strerror(error));
+    }
+
+    try {
+        m_httpServer = std::make_unique<HttpServer>(*this, httpPort);
+        m_httpServer->accept();
+        m_httpThread = std::thread([this]() { m_httpServer->io.run(); });
+        LOG_INFO("Metrics served on http://127.0.0.1:{}/metrics", httpPort);
+    } catch (const std::exception& e) {
+        m_httpServer.reset();
+        LOG_ERROR_CTX("Metrics", "Failed to start HTTP endpoint: {}", e.what());
+    }
+
+    m_samplerThread = std::thread(&MetricsRegistry::sampleLoop, this);
+}
+
+void MetricsRegistry::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    if (m_samplerThread.joinable()) {
+        m_samplerThread.join();
+    }
+    if (m_httpServer) {
+        m_httpServer->io.stop();
+        if (m_httpThread.joinable()) {
+            m_httpThread.join();
+        }
+        m_httpServer.reset();
+    }
+    if (m_sharedBlock) {
+        munmap(m_sharedBlock, sizeof(MetricsSharedBlock));
+        shm_unlink(m_shmName.c_str());
+        m_sharedBlock = nullptr;
+    }
+}
+
+void MetricsRegistry::sampleLoop() {
+    auto next = std::chrono::steady_clock::now();
+    while (m_running.load()) {
+        next += std::chrono::seconds(1);
+        updateRates();
+        writeSharedSnapshot();
+        while (m_running.load() && std::chrono::steady_clock::now() < next) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+}
+
+void MetricsRegistry::updateRates() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& family : m_counters) {
+        for (const auto& metric : family.second.byLabels) {
+            Rate& rate = m_rates[fullName(family.first, metric.first)];
+            uint64_t value = metric.second->value();
+            rate.perSecond = static_cast<double>(value - rate.lastValue);
+            rate.lastValue = value;
+        }
+    }
+}
+
+void MetricsRegistry::writeSharedSnapshot() {
+    if (!m_sharedBlock) {
+        return;
+    }
+
+    auto snapshot = std::make_unique<MetricsSnapshot>();
+    auto add = [&](const std::string& name, double value) {
+        if (snapshot->count == MetricsSnapshot::kMaxEntries) {
+            return;
+        }
+        MetricsSnapshot::Entry& entry = snapshot->entries[snapshot->count++];
+        std::strncpy(entry.name, name.c_str(), sizeof(entry.name) - 1);
+        entry.name[sizeof(entry.name) - 1] = '\0';
+        entry.value = value;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& family : m_counters) {
+            for (const auto& metric : family.second.byLabels) {
+                const std::string name = fullName(family.first, metric.first);
+                add(name, static_cast<double>(metric.second->value()));
+                add(fullName(family.first + ":rate", metric.first), m_rates[name].perSecond);
+            }
+        }
+        for (const auto& family : m_gauges) {
+            for (const auto& metric : family.second.byLabels) {
+                add(fullName(family.first, metric.first), static_cast<double>(metric.second->value()));
+            }
+        }
+        for (const auto& family : m_histograms) {
+            for (const auto& metric : family.second.byLabels) {
+                add(fullName(family.first + ":p50", metric.first), static_cast<double>(metric.second->percentile(0.5)));
+                add(fullName(family.first + ":p99", metric.first), static_cast<double>(metric.second->percentile(0.99)));
+                add(fullName(family.first + ":count", metric.first), static_cast<double>(metric.second->count()));
+            }
+        }
+    }
+
+    snapshot->updatedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    m_sharedBlock->snapshot.store(*snapshot);
+}
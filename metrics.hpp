@@ -0,0 +1,184 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include <chrono>
+#include "seqlock.hpp"
+
+// Live counters, gauges and latency histograms. Hot-path updates are
+// relaxed atomic increments; counters are sharded per thread so writers on
+// different threads never contend on a cache line. Gauges are not: set()
+// has no per-thread meaning. Histograms are not either: each series
+// belongs to one connection, account or stage and is written by one
+// thread at a time, while a shard costs the whole 2 KB bucket array.
+// Values are served as Prometheus text over a loopback HTTP port and
+// mirrored once per second into a shared-memory block that other
+// processes can read without syscalls.
+
+class MetricCounter {
+public:
+    static constexpr size_t kShards = 16;
+
+    void add(uint64_t n = 1) {
+        m_shards[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+
+private:
+    static size_t shardIndex();
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    Shard m_shards[kShards];
+};
+
+class MetricGauge {
+public:
+    void set(int64_t v) { m_value.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value{0};
+};
+
+// Log-linear histogram: four sub-buckets per power of two, so reported
+// percentiles are within ~19% of the true value. Values 0-3 have exact
+// buckets; percentiles report the upper bound of the bucket holding the
+// requested rank.
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 64 * 4;
+    // Exported _bucket bounds are 2^n - 1 for n up to this; every such
+    // bound is the top of a bucket, so the counts are exact
+    static constexpr int kBucketBits = 40;
+
+    void record(uint64_t value) {
+        m_buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t percentile(double q) const;
+    // Recorded values <= bound; exact when bound is the top of a bucket
+    uint64_t countAtMost(uint64_t bound) const;
+
+private:
+    static size_t bucketFor(uint64_t value);
+    static uint64_t bucketUpperBound(size_t bucket);
+
+    std::atomic<uint64_t> m_buckets[kBuckets] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+};
+
+// Layout of the shared-memory mirror. Readers copy the snapshot through the
+// seqlock and retry if it changed underneath them.
+struct MetricsSnapshot {
+    static constexpr uint32_t kMaxEntries = 512;
+
+    struct Entry {
+        char name[120];  // Metric name including Prometheus labels
+        double value;
+    };
+
+    uint64_t updatedAtMs = 0;
+    uint32_t count = 0;
+    Entry entries[kMaxEntries];
+};
+
+struct MetricsSharedBlock {
+    static constexpr uint64_t kMagic = 0x4d45545249435331ULL; // "METRICS1"
+
+    uint64_t magic;
+    SeqLock<MetricsSnapshot> snapshot;
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& getInstance() {
+        static MetricsRegistry instance;
+        return instance;
+    }
+
+    // Labels are rendered verbatim, e.g. R"(connection="main",channel="rpc")";
+    // build pairs holding runtime values with label()
+    // Returned references stay valid for the life of the process; look them
+    // up once and keep them rather than calling these on the hot path.
+    MetricCounter& counter(const std::string& name, const std::string& labels = "");
+    MetricGauge& gauge(const std::string& name, const std::string& labels = "");
+    LatencyHistogram& histogram(const std::string& name, const std::string& labels = "");
+
+    // name="value" with the value escaped for the Prometheus text format
+    static std::string label(std::string_view name, std::string_view value);
+
+    // Counters with a _per_second gauge each, gauges, and histograms with
+    // power-of-two _bucket bounds, _sum, _count and a _quantile gauge
+    std::string renderPrometheus();
+
+    void start(unsigned short httpPort, const std::string& shmName);
+    void stop();
+
+private:
+    MetricsRegistry();
+    ~MetricsRegistry();
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    template <typename T>
+    struct Family {
+        std::deque<T> metrics;
+        std::map<std::string, T*> byLabels;
+    };
+
+    static std::string fullName(const std::string& name, const std::string& labels);
+    void sampleLoop();
+    void updateRates();
+    void writeSharedSnapshot();
+
+    std::mutex m_mutex;
+    std::map<std::string, Family<MetricCounter>> m_counters;
+    std::map<std::string, Family<MetricGauge>> m_gauges;
+    std::map<std::string, Family<LatencyHistogram>> m_histograms;
+
+    // Per-second rates derived from counters by the sampler thread
+    struct Rate {
+        uint64_t lastValue = 0;
+        double perSecond = 0.0;
+    };
+    std::map<std::string, Rate> m_rates;
+
+    std::atomic<bool> m_running{false};
+    std::thread m_samplerThread;
+    std::thread m_httpThread;
+    struct HttpServer;
+    std::unique_ptr<HttpServer> m_httpServer;
+
+    std::string m_shmName;
+    MetricsSharedBlock* m_sharedBlock = nullptr;
+};
+
+// Records the time from construction to destruction, in microseconds
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram)
+        : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedLatency() {
+        m_histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_start).count());
+    }
+
+private:
+    LatencyHistogram& m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,386 @@
+#include "option_chain.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Built with -O3 -ffast-math -fopenmp-simd (see CMakeLists.txt) so the
+// loops below become packed SIMD and std::exp/std::log map to the vector
+// math library. Keep this file free of NaN/Inf checks for that reason.
+
+namespace {
+    constexpr double kSqrt2Pi = 2.5066282746310002;
+    constexpr double kInvSqrt2Pi = 0.3989422804014327;
+    constexpr double kMsPerYear = 365.0 * 24.0 * 3600.0 * 1000.0;
+    constexpr double kMinTime = 1e-6;
+    constexpr double kMinVol = 1e-3;
+    constexpr double kMaxVol = 10.0;
+    constexpr int kNewtonIterations = 16;
+
+    inline double normPdf(double x) {
+        return kInvSqrt2Pi * std::exp(-0.5 * x * x);
+    }
+
+    // Abramowitz & Stegun 26.2.17, |error| < 7.5e-8, given pdf = normPdf(x).
+    // Branch-free so it vectorizes; taking the density lets callers share one exp.
+    inline double normCdf(double x, double pdf) {
+        const double t = 1.0 / (1.0 + 0.2316419 * std::fabs(x));
+        const double poly = t * (0.319381530 + t * (-0.356563782 + t * (1.781477937 +
+                            t * (-1.821255978 + t * 1.330274429))));
+        const double tail = pdf * poly;
+        return x >= 0.0 ? 1.0 - tail : tail;
+    }
+
+    // Black-76 price and Greeks, all in USD per unit of underlying
+    void blackKernel(size_t n, const double* __restrict forward, const double* __restrict strike,
+                     const double* __restrict time, const double* __restrict sigma,
+                     const double* __restrict callPut, double* __restrict theo,
+                     double* __restrict delta, double* __restrict gamma,
+                     double* __restrict vega, double* __restrict theta) {
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            const double f = forward[i];
+            const double k = strike[i];
+            const double cp = callPut[i];
+            const double sqrtT = std::sqrt(time[i]);
+            const double vs = sigma[i] * sqrtT;
+            const double d1 = (std::log(f / k) + 0.5 * vs * vs) / vs;
+            const double d2 = d1 - vs;
+            // n(d2) = n(d1) * F / K, so one exp covers both densities
+            const double pdf = normPdf(d1);
+            const double nd1 = normCdf(cp * d1, pdf);
+            const double nd2 = normCdf(cp * d2, pdf * f / k);
+
+            theo[i] = cp * (f * nd1 - k * nd2);
+            delta[i] = cp * nd1;
+            gamma[i] = pdf / (f * vs);
+            vega[i] = f * pdf * sqrtT;
+            theta[i] = -f * pdf * sigma[i] / (2.0 * sqrtT);
+        }
+    }
+
+    // Newton-Raphson on Black-76, safeguarded by a per-contract bracket: a
+    // step that leaves the bracket bisects instead, which rescues deep
+    // out-of-the-money quotes where vega is tiny. A fixed iteration count
+    // keeps every lane on the same instructions. Quotes at or below
+    // intrinsic get vol 0.
+    void impliedVolKernel(size_t n, const double* __restrict forward, const double* __restrict strike,
+                          const double* __restrict time, const double* __restrict callPut,
+                          const double* __restrict target, double* __restrict sigma,
+                          double* __restrict lower, double* __restrict upper) {
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            // Brenner-Subrahmanyam seed
+            const double seed = kSqrt2Pi / std::sqrt(time[i]) * target[i] / forward[i];
+            sigma[i] = std::min(std::max(seed, 0.1), 3.0);
+            lower[i] = kMinVol;
+            upper[i] = kMaxVol;
+        }
+
+        for (int iteration = 0; iteration < kNewtonIterations; ++iteration) {
+#pragma omp simd
+            for (size_t i = 0; i < n; ++i) {
+                const double f = forward[i];
+                const double k = strike[i];
+                const double cp = callPut[i];
+                const double sqrtT = std::sqrt(time[i]);
+                const double vs = sigma[i] * sqrtT;
+                const double d1 = (std::log(f / k) + 0.5 * vs * vs) / vs;
+                const double d2 = d1 - vs;
+                const double pdf = normPdf(d1);
+                const double price = cp * (f * normCdf(cp * d1, pdf) - k * normCdf(cp * d2, pdf * f / k));
+                const double vega = std::max(f * pdf * sqrtT, 1e-12);
+                const bool high = price > target[i];
+                const double lo = high ? lower[i] : sigma[i];
+                const double hi = high ? sigma[i] : upper[i];
+                const double next = sigma[i] - (price - target[i]) / vega;
+                sigma[i] = next > lo && next < hi ? next : 0.5 * (lo + hi);
+                lower[i] = lo;
+                upper[i] = hi;
+            }
+        }
+
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            const double intrinsic = std::max(callPut[i] * (forward[i] - strike[i]), 0.0);
+            sigma[i] = target[i] > intrinsic ? sigma[i] : 0.0;
+        }
+    }
+
+    uint64_t daysFromCivil(int year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(year - era * 400);
+        const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return static_cast<uint64_t>(era * 146097 + static_cast<int>(doe) - 719468);
+    }
+}
+
+void OptionChainEngine::Batch::resize(size_t n) {
+    for (auto* v : {&forward, &strike, &time, &callPut, &target, &sigma, &lower, &upper,
+                    &theo, &delta, &gamma, &vega, &theta}) {
+        if (v->size() < n) {
+            v->resize(n);
+        }
+    }
+    if (contract.size() < n) {
+        contract.resize(n);
+    }
+}
+
+OptionChainEngine::OptionChainEngine()
+    : m_repriceLatency(&MetricsRegistry::getInstance().histogram("deribit_option_chain_reprice_ns")),
+      m_ivLatency(&MetricsRegistry::getInstance().histogram("deribit_option_chain_iv_solve_ns")) {
+}
+
+bool OptionChainEngine::parseInstrument(std::string_view instrument, std::string_view& currency,
+                                        uint64_t& expiryMs, double& strike, double& callPut) {
+    // CURRENCY-DMMMYY-STRIKE-C|P, e.g. BTC-27DEC24-60000-C. Linear options
+    // (XRP_USDC-7MAR25-2d5-P) are quoted in USDC rather than the coin, so
+    // the coin-denominated model does not apply to them
+    size_t first = instrument.find('-');
+    size_t second = instrument.find('-', first + 1);
+    size_t third = instrument.find('-', second + 1);
+    if (first == std::string_view::npos || second == std::string_view::npos ||
+        third == std::string_view::npos || third + 2 != instrument.size()) {
+        return false;
+    }
+
+    const char type = instrument[third + 1];
+    if (type != 'C' && type != 'P') {
+        return false;
+    }
+    callPut = type == 'C' ? 1.0 : -1.0;
+    currency = instrument.substr(0, first);
+    if (currency.find('_') != std::string_view::npos) {
+        return false;
+    }
+
+    std::string_view date = instrument.substr(first + 1, second - first - 1);
+    if (date.size() < 6 || date.size() > 7) {
+        return false;
+    }
+    const size_t dayDigits = date.size() - 5;
+    unsigned day = 0;
+    for (size_t i = 0; i < dayDigits; ++i) {
+        day = day * 10 + static_cast<unsigned>(date[i] - '0');
+    }
+    static const char* kMonths = "JANFEBMARAPRMAYJUNJULAUGSEPOCTNOVDEC";
+    const char* match = std::search(kMonths, kMonths + 36, date.begin() + dayDigits, date.begin() + dayDigits + 3);
+    if (match == kMonths + 36 || (match - kMonths) % 3 != 0) {
+        return false;
+    }
+    const unsigned month = static_cast<unsigned>((match - kMonths) / 3 + 1);
+    const int year = 2000 + (date[dayDigits + 3] - '0') * 10 + (date[dayDigits + 4] - '0');
+    // Deribit options expire at 08:00 UTC
+    expiryMs = (daysFromCivil(year, month, day) * 86400ULL + 8 * 3600ULL) * 1000ULL;
+
+    std::string_view strikeText = instrument.substr(second + 1, third - second - 1);
+    double value = 0.0;
+    double scale = 0.0;
+    for (char c : strikeText) {
+        if (c == 'd' || c == '.') {
+            scale = 1.0;
+        } else if (c >= '0' && c <= '9') {
+            value = value * 10.0 + (c - '0');
+            scale *= 10.0;
+        } else {
+            return false;
+        }
+    }
+    strike = scale > 0.0 ? value / scale : value;
+    return strike > 0.0;
+}
+
+OptionChain& OptionChainEngine::chainFor(std::string_view currency) {
+    auto it = m_chains.find(currency);
+    if (it == m_chains.end()) {
+        it = m_chains.emplace(std::string(currency), OptionChain{}).first;
+    }
+    return it->second;
+}
+
+uint32_t OptionChainEngine::addContract(OptionChain& chain, std::string_view instrument,
+                                        uint64_t expiryMs, double strike, double callPut) {
+    const uint32_t index = static_cast<uint32_t>(chain.size());
+    chain.names.emplace_back(instrument);
+    chain.strike.push_back(strike);
+    chain.expiryMs.push_back(expiryMs);
+    chain.callPut.push_back(callPut);
+    for (auto* v : {&chain.bid, &chain.ask, &chain.mark, &chain.forward, &chain.basis,
+                    &chain.timeToExpiry, &chain.iv, &chain.theo, &chain.delta,
+                    &chain.gamma, &chain.vega, &chain.theta}) {
+        v->push_back(0.0);
+    }
+    chain.isDirty.push_back(0);
+    chain.byName.emplace(std::string(instrument), index);
+    return index;
+}
+
+bool OptionChainEngine::onOptionTicker(std::string_view instrument, double bid, double ask, double mark,
+                                       double underlyingPrice, double indexPrice, uint64_t timestampMs) {
+    OptionChain* chain = nullptr;
+    uint32_t index = 0;
+
+    // Fast path: known contract, found without reparsing the name
+    std::string_view currency = instrument.substr(0, instrument.find('-'));
+    auto chainIt = m_chains.find(currency);
+    if (chainIt != m_chains.end()) {
+        auto contract = chainIt->second.byName.find(instrument);
+        if (contract != chainIt->second.byName.end()) {
+            chain = &chainIt->second;
+            index = contract->second;
+        }
+    }
+    if (!chain) {
+        uint64_t expiryMs;
+        double strike, callPut;
+        if (!parseInstrument(instrument, currency, expiryMs, strike, callPut)) {
+            return false;
+        }
+        chain = &chainFor(currency);
+        index = addContract(*chain, instrument, expiryMs, strike, callPut);
+    }
+
+    chain->bid[index] = bid;
+    chain->ask[index] = ask;
+    chain->mark[index] = mark;
+    chain->forward[index] = underlyingPrice;
+    chain->basis[index] = indexPrice > 0.0 ? underlyingPrice - indexPrice : 0.0;
+    chain->nowMs = std::max(chain->nowMs, timestampMs);
+    if (!chain->isDirty[index]) {
+        chain->isDirty[index] = 1;
+        chain->dirty.push_back(index);
+    }
+    return true;
+}
+
+void OptionChainEngine::onIndexPrice(std::string_view currency, double indexPrice, uint64_t timestampMs) {
+    auto it = m_chains.find(currency);
+    if (it == m_chains.end() || indexPrice <= 0.0 || indexPrice == it->second.index) {
+        return;
+    }
+    it->second.index = indexPrice;
+    it->second.nowMs = std::max(it->second.nowMs, timestampMs);
+    it->second.underlyingMoved = true;
+}
+
+void OptionChainEngine::recompute() {
+    for (auto& entry : m_chains) {
+        OptionChain& chain = entry.second;
+        if (!chain.dirty.empty() || chain.underlyingMoved) {
+            recompute(chain);
+        }
+    }
+}
+
+void OptionChainEngine::recompute(OptionChain& chain) {
+    const auto start = std::chrono::steady_clock::now();
+    const double now = static_cast<double>(chain.nowMs);
+    const size_t dirtyCount = chain.dirty.size();
+    m_batch.resize(std::max(dirtyCount, size_t(1)));
+
+    // Re-solve implied vols for contracts with new quotes: gather the dirty
+    // subset into contiguous arrays, run the kernel, scatter the results.
+    // Contracts without a mark or forward yet are left out; the kernels
+    // would turn them into NaNs
+    size_t count = 0;
+    for (size_t j = 0; j < dirtyCount; ++j) {
+        const uint32_t i = chain.dirty[j];
+        if (chain.forward[i] <= 0.0 || chain.mark[i] <= 0.0) {
+            chain.iv[i] = 0.0;
+            chain.theo[i] = chain.delta[i] = chain.gamma[i] = chain.vega[i] = chain.theta[i] = 0.0;
+            continue;
+        }
+        m_batch.contract[count] = i;
+        m_batch.forward[count] = chain.forward[i];
+        m_batch.strike[count] = chain.strike[i];
+        m_batch.time[count] = std::max((static_cast<double>(chain.expiryMs[i]) - now) / kMsPerYear, kMinTime);
+        m_batch.callPut[count] = chain.callPut[i];
+        m_batch.target[count] = chain.mark[i] * chain.forward[i];
+        ++count;
+    }
+    if (count > 0) {
+        impliedVolKernel(count, m_batch.forward.data(), m_batch.strike.data(), m_batch.time.data(),
+                         m_batch.callPut.data(), m_batch.target.data(), m_batch.sigma.data(),
+                         m_batch.lower.data(), m_batch.upper.data());
+        for (size_t j = 0; j < count; ++j) {
+            chain.iv[m_batch.contract[j]] = m_batch.sigma[j];
+        }
+        m_ivLatency->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    const size_t n = chain.size();
+    double* sigma = chain.iv.data();
+    if (chain.underlyingMoved) {
+        // Underlying tick: shift every forward by the index move and reprice
+        // the whole chain in place at current vols
+        const double index = chain.index;
+        const uint64_t* expiry = chain.expiryMs.data();
+        double* forward = chain.forward.data();
+        const double* basis = chain.basis.data();
+        double* time = chain.timeToExpiry.data();
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            forward[i] = index + basis[i];
+            time[i] = std::max((static_cast<double>(expiry[i]) - now) / kMsPerYear, kMinTime);
+        }
+        // Contracts without a solved vol would divide by zero; price them at
+        // the floor. Lanes without a positive forward run on the strike
+        // instead and are zeroed afterwards, so no lane produces a NaN
+        m_batch.resize(n);
+        const double* strike = chain.strike.data();
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            m_batch.sigma[i] = std::max(sigma[i], kMinVol);
+            m_batch.forward[i] = forward[i] > 0.0 ? forward[i] : strike[i];
+        }
+        blackKernel(n, m_batch.forward.data(), strike, time, m_batch.sigma.data(), chain.callPut.data(),
+                    chain.theo.data(), chain.delta.data(), chain.gamma.data(), chain.vega.data(),
+                    chain.theta.data());
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i) {
+            const bool priced = forward[i] > 0.0;
+            const double f = m_batch.forward[i];
+            chain.theo[i] = priced ? chain.theo[i] / f : 0.0;
+            chain.delta[i] = priced ? chain.delta[i] : 0.0;
+            chain.gamma[i] = priced ? chain.gamma[i] : 0.0;
+            chain.vega[i] = priced ? chain.vega[i] / f : 0.0;
+            chain.theta[i] = priced ? chain.theta[i] / f : 0.0;
+        }
+    } else {
+        for (size_t j = 0; j < count; ++j) {
+            m_batch.sigma[j] = std::max(m_batch.sigma[j], kMinVol);
+        }
+        blackKernel(count, m_batch.forward.data(), m_batch.strike.data(), m_batch.time.data(),
+                    m_batch.sigma.data(), m_batch.callPut.data(), m_batch.theo.data(),
+                    m_batch.delta.data(), m_batch.gamma.data(), m_batch.vega.data(), m_batch.theta.data());
+        for (size_t j = 0; j < count; ++j) {
+            const uint32_t i = m_batch.contract[j];
+            const double f = m_batch.forward[j];
+            chain.timeToExpiry[i] = m_batch.time[j];
+            chain.theo[i] = m_batch.theo[j] / f;
+            chain.delta[i] = m_batch.delta[j];
+            chain.gamma[i] = m_batch.gamma[j];
+            chain.vega[i] = m_batch.vega[j] / f;
+            chain.theta[i] = m_batch.theta[j] / f;
+        }
+    }
+
+    for (uint32_t i : chain.dirty) {
+        chain.isDirty[i] = 0;
+    }
+    chain.dirty.clear();
+    chain.underlyingMoved = false;
+
+    m_repriceLatency->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+const OptionChain* OptionChainEngine::chain(std::string_view currency) const {
+    auto it = m_chains.find(currency);
+    return it == m_chains.end() ? nullptr : &it->second;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+class LatencyHistogram;
+
+// One underlying's option chain in structure-of-arrays layout. Each
+// contract is an index into parallel arrays, so the pricing kernels run as
+// straight loops over contiguous doubles that the compiler vectorizes.
+//
+// Prices follow Deribit conventions: quotes are in units of the underlying
+// coin, the forward is the ticker's underlying_price, rates are zero
+// (Black-76 on the forward).
+struct OptionChain {
+    // Contract definition
+    std::vector<std::string> names;
+    std::vector<double> strike;
+    std::vector<uint64_t> expiryMs;
+    std::vector<double> callPut;        // +1 call, -1 put
+
+    // Inputs from ticker.* channels
+    std::vector<double> bid;
+    std::vector<double> ask;
+    std::vector<double> mark;
+    std::vector<double> forward;
+    std::vector<double> basis;          // forward - index at the last option tick
+
+    // Outputs
+    std::vector<double> timeToExpiry;   // Years
+    std::vector<double> iv;
+    std::vector<double> theo;           // Model price in coin units
+    std::vector<double> delta;
+    std::vector<double> gamma;          // Per unit of underlying price
+    std::vector<double> vega;           // Coin per 1.00 of vol
+    std::vector<double> theta;          // Coin per year
+
+    // Contracts whose quote changed and need a new implied vol
+    std::vector<uint32_t> dirty;
+    std::vector<uint8_t> isDirty;
+    // Underlying moved: reprice every contract at its current vol
+    bool underlyingMoved = false;
+    double index = 0.0;
+    uint64_t nowMs = 0;
+
+    std::map<std::string, uint32_t, std::less<>> byName;
+
+    size_t size() const { return strike.size(); }
+};
+
+// Maintains option chains per underlying from ticker updates and
+// recomputes implied vols and Greeks only for what changed: a quote
+// update re-solves that contract's vol, an underlying tick reprices the
+// whole chain at existing vols. Runs on the IO thread.
+class OptionChainEngine {
+public:
+    OptionChainEngine();
+
+    // Returns false if the name is not an inverse Deribit option (e.g.
+    // BTC-27DEC24-60000-C); linear USDC options are not modelled
+    bool onOptionTicker(std::string_view instrument, double bid, double ask, double mark,
+                        double underlyingPrice, double indexPrice, uint64_t timestampMs);
+    void onIndexPrice(std::string_view currency, double indexPrice, uint64_t timestampMs);
+
+    // Runs the batch kernels for all pending work
+    void recompute();
+
+    const OptionChain* chain(std::string_view currency) const;
+
+    static bool parseInstrument(std::string_view instrument, std::string_view& currency,
+                                uint64_t& expiryMs, double& strike, double& callPut);
+
+private:
+    OptionChain& chainFor(std::string_view currency);
+    uint32_t addContract(OptionChain& chain, std::string_view instrument, uint64_t expiryMs,
+                         double strike, double callPut);
+    void recompute(OptionChain& chain);
+
+    std::map<std::string, OptionChain, std::less<>> m_chains;
+
+    // Scratch buffers for gathering the dirty subset into contiguous arrays
+    struct Batch {
+        std::vector<double> forward, strike, time, callPut, target, sigma, lower, upper;
+        std::vector<double> theo, delta, gamma, vega, theta;
+        std::vector<uint32_t> contract;     // Chain index of each gathered lane
+        void resize(size_t n);
+    } m_batch;
+
+    LatencyHistogram* m_repriceLatency;
+    LatencyHistogram* m_ivLatency;
+};
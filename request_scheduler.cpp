@@ -0,0 +1,156 @@
+#include "request_scheduler.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+
+namespace {
+    const char* kPriorityNames[RequestScheduler::kPriorities] = {"cancel", "risk_reducing", "new_order", "query"};
+
+    bool startsWith(const std::string& text, const char* prefix) {
+        return text.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+    }
+}
+
+RequestScheduler::RequestScheduler(const RateLimitConfig& config, const std::string& account)
+    : m_config(config),
+      m_credits(config.maxCredits),
+      m_lastRefill(std::chrono::steady_clock::now()) {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    const std::string labels = MetricsRegistry::label("account", account);
+    for (size_t i = 0; i < kPriorities; ++i) {
+        m_queueWait[i] = &metrics.histogram("deribit_scheduler_queue_wait_us",
+                                            labels + "," + MetricsRegistry::label("priority", kPriorityNames[i]));
+    }
+    m_queueDepth = &metrics.gauge("deribit_scheduler_queued_requests", labels);
+    m_creditsGauge = &metrics.gauge("deribit_scheduler_credits", labels);
+    m_throttled = &metrics.counter("deribit_scheduler_throttled_total", labels);
+    m_creditsGauge->set(static_cast<int64_t>(m_credits));
+}
+
+void RequestScheduler::refill(std::chrono::steady_clock::time_point now) {
+    const double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+    m_credits = std::min(m_config.maxCredits, m_credits + elapsed * m_config.refillPerSecond);
+    m_lastRefill = now;
+}
+
+bool RequestScheduler::isNext(size_t priority, uint64_t ticket) const {
+    for (size_t p = 0; p < priority; ++p) {
+        if (!m_waiting[p].empty()) {
+            return false;
+        }
+    }
+    return m_waiting[priority].front() == ticket;
+}
+
+std::chrono::microseconds RequestScheduler::acquire(Priority priority) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t index = static_cast<size_t>(priority);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t ticket = m_nextTicket++;
+    m_waiting[index].push_back(ticket);
+    m_queueDepth->add(1);
+
+    while (true) {
+        if (isNext(index, ticket)) {
+            const auto now = std::chrono::steady_clock::now();
+            refill(now);
+            if (m_credits >= m_config.requestCost) {
+                break;
+            }
+            // Sleep until the bucket can pay; a higher-priority arrival
+            // takes over as head and wakes us when it is done
+            const double deficit = (m_config.requestCost - m_credits) / m_config.refillPerSecond;
+            m_wakeup.wait_until(lock, now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(deficit)));
+        } else {
+            m_wakeup.wait(lock);
+        }
+    }
+
+    m_credits -= m_config.requestCost;
+    m_waiting[index].pop_front();
+    m_queueDepth->add(-1);
+    m_creditsGauge->set(static_cast<int64_t>(m_credits));
+    lock.unlock();
+    m_wakeup.notify_all();
+
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    m_queueWait[index]->record(waited.count());
+    return waited;
+}
+
+bool RequestScheduler::tryAcquire(Priority priority) {
+    const size_t index = static_cast<size_t>(priority);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t p = 0; p <= index; ++p) {
+        if (!m_waiting[p].empty()) {
+            return false;
+        }
+    }
+    refill(std::chrono::steady_clock::now());
+    if (m_credits < m_config.requestCost) {
+        return false;
+    }
+    m_credits -= m_config.requestCost;
+    m_creditsGauge->set(static_cast<int64_t>(m_credits));
+    m_queueWait[index]->record(0);
+    return true;
+}
+
+std::chrono::microseconds RequestScheduler::untilAffordable() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    refill(std::chrono::steady_clock::now());
+    if (m_credits >= m_config.requestCost) {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<double>(
+        (m_config.requestCost - m_credits) / m_config.refillPerSecond)) + std::chrono::microseconds(1);
+}
+
+void RequestScheduler::onThrottled() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_credits = 0.0;
+        m_lastRefill = std::chrono::steady_clock::now();
+        m_creditsGauge->set(0);
+    }
+    m_throttled->add();
+    LOG_WARNING("Rate limit hit (too_many_requests); local credit bucket emptied");
+}
+
+double RequestScheduler::availableCredits() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    refill(std::chrono::steady_clock::now());
+    return m_credits;
+}
+
+size_t RequestScheduler::queued() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t total = 0;
+    for (const auto& queue : m_waiting) {
+        total += queue.size();
+    }
+    return total;
+}
+
+RequestScheduler::Priority RequestScheduler::classify(const std::string& method, bool reduceOnly) {
+    if (startsWith(method, "private/cancel")) {
+        return Priority::CANCEL;
+    }
+    if (startsWith(method, "private/close_position")) {
+        return Priority::RISK_REDUCING;
+    }
+    if (startsWith(method, "private/buy") || startsWith(method, "private/sell") ||
+        startsWith(method, "private/edit")) {
+        return reduceOnly ? Priority::RISK_REDUCING : Priority::NEW_ORDER;
+    }
+    return Priority::QUERY;
+}
+
+RequestScheduler::Priority RequestScheduler::classifyEndpoint(const std::string& endpoint) {
+    const size_t query = endpoint.find('?');
+    const bool reduceOnly = query != std::string::npos &&
+                            endpoint.find("reduce_only=true", query) != std::string::npos;
+    return classify(endpoint.substr(0, query), reduceOnly);
+}
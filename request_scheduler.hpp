@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+class LatencyHistogram;
+class MetricGauge;
+class MetricCounter;
+
+// Defaults match Deribit's non-matching-engine limits
+struct RateLimitConfig {
+    double maxCredits = 50000.0;
+    double refillPerSecond = 10000.0;
+    double requestCost = 500.0;
+};
+
+// Local model of Deribit's credit-based rate limit, shared by every
+// outbound path of one account (REST and WebSocket). Each request costs
+// credits; the bucket refills continuously up to a cap. Callers block in
+// acquire() until it is their turn and the bucket can pay, so bursts are
+// paced at the full allowance instead of being rejected with
+// too_many_requests. IO threads must not block: they use tryAcquire(),
+// keep what could not go and retry after untilAffordable().
+//
+// Waiting requests are served strictly by priority, then in arrival
+// order: a cancel never waits behind a queued new order or query.
+class RequestScheduler {
+public:
+    enum class Priority {
+        CANCEL = 0,
+        RISK_REDUCING,      // Reduce-only orders, closing positions
+        NEW_ORDER,
+        QUERY               // Reads, subscriptions, auth
+    };
+    static constexpr size_t kPriorities = 4;
+
+    explicit RequestScheduler(const RateLimitConfig& config = RateLimitConfig{}, const std::string& account = "main");
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    // Blocks until the request may be sent and charges it; returns the time spent queued
+    std::chrono::microseconds acquire(Priority priority);
+    // Charges and returns true only if the request can go now without
+    // waiting and without overtaking anything queued at the same or higher priority
+    bool tryAcquire(Priority priority);
+    // How long until the bucket can pay for one request; zero if it can now
+    std::chrono::microseconds untilAffordable();
+
+    // The exchange answered too_many_requests: the local model was ahead
+    // of the server's, so empty the bucket and let it refill from zero
+    void onThrottled();
+
+    double availableCredits();
+    size_t queued() const;
+
+    // JSON-RPC method name, e.g. "private/cancel_all"
+    static Priority classify(const std::string& method, bool reduceOnly = false);
+    // REST endpoint with query string, e.g. "private/sell?...&reduce_only=true"
+    static Priority classifyEndpoint(const std::string& endpoint);
+
+    // Deribit error code for too_many_requests
+    static constexpr int kTooManyRequests = 10028;
+
+private:
+    // Caller holds m_mutex
+    void refill(std::chrono::steady_clock::time_point now);
+    bool isNext(size_t priority, uint64_t ticket) const;
+
+    RateLimitConfig m_config;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    double m_credits;
+    std::chrono::steady_clock::time_point m_lastRefill;
+    std::deque<uint64_t> m_waiting[kPriorities];
+    uint64_t m_nextTicket = 0;
+
+    LatencyHistogram* m_queueWait[kPriorities];
+    MetricGauge* m_queueDepth;
+    MetricGauge* m_creditsGauge;
+    MetricCounter* m_throttled;
+};
@@ -0,0 +1,100 @@
+#include "rx_timestamps.hpp"
+#include <atomic>
+#include <ctime>
+
+#ifdef DERIBIT_RX_TIMESTAMPING
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+    // Indexed by fd; descriptors beyond this are never timestamped
+    constexpr int kMaxFd = 4096;
+    std::atomic<bool> s_enabled[kMaxFd];
+
+    thread_local RxTimestamping::Sample t_lastRead;
+}
+
+#ifdef DERIBIT_RX_TIMESTAMPING
+extern "C" ssize_t __real_recvmsg(int fd, struct msghdr* msg, int flags);
+
+// Every recvmsg() in objects linked with --wrap=recvmsg lands here,
+// including the ones inlined from asio's socket_ops
+extern "C" ssize_t __wrap_recvmsg(int fd, struct msghdr* msg, int flags) {
+    if (fd < 0 || fd >= kMaxFd || !s_enabled[fd].load(std::memory_order_relaxed) || msg->msg_control) {
+        return __real_recvmsg(fd, msg, flags);
+    }
+
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(struct scm_timestamping))];
+    msg->msg_control = control;
+    msg->msg_controllen = sizeof(control);
+    const ssize_t received = __real_recvmsg(fd, msg, flags);
+    const int64_t readNs = RxTimestamping::nowNs();
+
+    if (received > 0) {
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                // ts[0] is the software stamp; ts[2] would be hardware
+                const auto* stamps = reinterpret_cast<const struct scm_timestamping*>(CMSG_DATA(cmsg));
+                t_lastRead.fd = fd;
+                t_lastRead.kernelNs = static_cast<int64_t>(stamps->ts[0].tv_sec) * 1000000000LL + stamps->ts[0].tv_nsec;
+                t_lastRead.readNs = readNs;
+            }
+        }
+    }
+
+    // asio reuses its msghdr; hand it back the way it was passed in
+    msg->msg_control = nullptr;
+    msg->msg_controllen = 0;
+    return received;
+}
+#endif
+
+namespace RxTimestamping {
+    bool supported() {
+#ifdef DERIBIT_RX_TIMESTAMPING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool enable(int fd) {
+#ifdef DERIBIT_RX_TIMESTAMPING
+        if (fd < 0 || fd >= kMaxFd) {
+            return false;
+        }
+        const int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0) {
+            return false;
+        }
+        s_enabled[fd].store(true, std::memory_order_relaxed);
+        return true;
+#else
+        (void)fd;
+        return false;
+#endif
+    }
+
+    void disable(int fd) {
+        if (fd >= 0 && fd < kMaxFd) {
+            s_enabled[fd].store(false, std::memory_order_relaxed);
+        }
+    }
+
+    bool take(int fd, Sample& sample) {
+        if (t_lastRead.fd != fd || fd < 0) {
+            return false;
+        }
+        sample = t_lastRead;
+        t_lastRead.fd = -1;
+        return true;
+    }
+
+    int64_t nowNs() {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// Kernel receive timestamps for the WebSocket socket. With
+// SO_TIMESTAMPING (software RX) enabled, the kernel stamps each segment
+// when it reaches the socket; recvmsg() is wrapped at link time
+// (-Wl,--wrap=recvmsg, DERIBIT_RX_TIMESTAMPING) to pick the stamp out of
+// the control data asio never asks for. Both stamps are CLOCK_REALTIME
+// nanoseconds so they can be compared with nowNs().
+namespace RxTimestamping {
+    struct Sample {
+        int fd = -1;
+        int64_t kernelNs = 0;   // Segment reached the socket
+        int64_t readNs = 0;     // recvmsg() returned it to user space
+    };
+
+    // False when built without DERIBIT_RX_TIMESTAMPING
+    bool supported();
+
+    // Turns on RX timestamps for the socket; false if unsupported or the
+    // kernel refused. The kernel enables stamping asynchronously, so the
+    // first reads after this may carry no stamp.
+    bool enable(int fd);
+    void disable(int fd);
+
+    // Takes the stamps of the last read of fd on this thread. Each read is
+    // handed out once: when one read carries several frames only the first
+    // gets the kernel and read stages. With several IO threads the read and
+    // its handler may run on different threads, and the pair is then missed.
+    bool take(int fd, Sample& sample);
+
+    int64_t nowNs();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock. The writer never blocks; readers retry when
+// they observe a concurrent write. The sequence is odd while a write is in
+// progress and advances by two per completed write, so it doubles as a
+// version number for change detection. Standard layout, so it can also be
+// placed in shared memory.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    void store(const T& value) {
+        uint64_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&m_value, &value, sizeof(T));
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Returns false if a write was in progress or raced with the copy.
+    bool tryLoad(T& out, uint64_t& version) const {
+        uint64_t before = m_seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            return false;
+        }
+        std::memcpy(&out, &m_value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = m_seq.load(std::memory_order_relaxed);
+        version = before;
+        return before == after;
+    }
+
+    uint64_t load(T& out) const {
+        uint64_t version;
+        while (!tryLoad(out, version)) {
+        }
+        return version;
+    }
+
+    // Even number of the last completed write; 0 means never written.
+    uint64_t version() const {
+        return m_seq.load(std::memory_order_acquire) & ~uint64_t(1);
+    }
+
+private:
+    std::atomic<uint64_t> m_seq{0};
+    T m_value{};
+};
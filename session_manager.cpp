@@ -0,0 +1,77 @@
+#include "session_manager.hpp"
+#include "trader.hpp"
+#include "websocket.hpp"
+#include "logger.hpp"
+#include "tracing.hpp"
+#include <stdexcept>
+
+SessionManager::SessionManager(const std::string& wsUri, size_t ioThreads)
+    : m_wsUri(wsUri),
+      m_ioThreads(ioThreads == 0 ? 1 : ioThreads) {
+}
+
+SessionManager::~SessionManager() {
+    stop();
+}
+
+SessionManager::Session& SessionManager::addAccount(const AccountConfig& config) {
+    if (find(config.name)) {
+        throw std::runtime_error("Duplicate account: " + config.name);
+    }
+
+    auto session = std::make_unique<Session>();
+    session->name = config.name;
+    session->scheduler = std::make_unique<RequestScheduler>(config.rateLimit, config.name);
+    session->trader = std::make_unique<Trader>(config.clientId, config.clientSecret, config.name);
+    session->trader->setScheduler(session->scheduler.get());
+    session->wsClient = std::make_unique<DeribitWebSocketClient>(m_wsUri, config.clientId, config.clientSecret,
+                                                                 config.name, &m_ioService);
+    session->wsClient->setScheduler(session->scheduler.get());
+
+    LOG_INFO("Account {} added", config.name);
+    m_sessions.push_back(std::move(session));
+    return *m_sessions.back();
+}
+
+void SessionManager::start() {
+    // Keeps run() from returning while connections are between operations
+    m_work = std::make_unique<boost::asio::io_service::work>(m_ioService);
+
+    for (auto& session : m_sessions) {
+        session->wsClient->connect();
+    }
+
+    for (size_t i = 0; i < m_ioThreads; ++i) {
+        m_threads.emplace_back([this, i]() {
+            LOG_INFO("IO thread {} started", i);
+            Tracer::getInstance().setThreadName("io-" + std::to_string(i));
+            try {
+                m_ioService.run();
+            } catch (const std::exception& e) {
+                LOG_ERROR_CTX("IO Thread", "{}", e.what());
+            }
+            LOG_INFO("IO thread {} stopped", i);
+        });
+    }
+    LOG_INFO("Session manager running {} accounts on {} IO threads", m_sessions.size(), m_ioThreads);
+}
+
+void SessionManager::stop() {
+    m_work.reset();
+    m_ioService.stop();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    m_threads.clear();
+}
+
+SessionManager::Session* SessionManager::find(const std::string& name) {
+    for (auto& session : m_sessions) {
+        if (session->name == name) {
+            return session.get();
+        }
+    }
+    return nullptr;
+}
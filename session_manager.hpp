@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio/io_service.hpp>
+#include "request_scheduler.hpp"
+
+class Trader;
+class DeribitWebSocketClient;
+
+struct AccountConfig {
+    std::string name;
+    std::string clientId;
+    std::string clientSecret;
+    RateLimitConfig rateLimit;
+};
+
+// Hosts several authenticated accounts in one process. Each account keeps
+// its own WebSocket connection, access tokens, request ids and credit
+// bucket; all connections share one io_service driven by a fixed number
+// of threads, so adding an account adds a socket, not a thread.
+// websocketpp runs each connection's handlers (open, message, close) on
+// the connection's strand, so those never overlap for one account. The
+// client's drain timer and every request sent from the main thread run
+// outside that strand; state they share with the handlers is behind the
+// client's mutexes or atomic.
+class SessionManager {
+public:
+    struct Session {
+        std::string name;
+        std::unique_ptr<RequestScheduler> scheduler;
+        std::unique_ptr<Trader> trader;                 // REST, own token and connection pool
+        std::unique_ptr<DeribitWebSocketClient> wsClient;
+    };
+
+    SessionManager(const std::string& wsUri, size_t ioThreads);
+    ~SessionManager();
+    SessionManager(const SessionManager&) = delete;
+    SessionManager& operator=(const SessionManager&) = delete;
+
+    // Before start(); throws on a duplicate name
+    Session& addAccount(const AccountConfig& config);
+
+    // Connects every account and starts the IO threads
+    void start();
+    void stop();
+
+    // nullptr if no such account
+    Session* find(const std::string& name);
+    Session& at(size_t index) { return *m_sessions.at(index); }
+    size_t size() const { return m_sessions.size(); }
+
+private:
+    std::string m_wsUri;
+    size_t m_ioThreads;
+    boost::asio::io_service m_ioService;
+    std::unique_ptr<boost::asio::io_service::work> m_work;
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<Session>> m_sessions;
+};
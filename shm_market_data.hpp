@@ -0,0 +1,147 @@
+#pragma once
+
+// Header-only layout and reader for the market data that crypto_trader
+// publishes into POSIX shared memory. Any local process can include this
+// file, open the region read-only and read the latest per-instrument state
+// without sockets or syscalls on the read path. Each field group sits
+// behind its own seqlock, so readers never block the publisher.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "seqlock.hpp"
+#include "market_data.hpp"
+
+struct ShmTrade {
+    double price = 0.0;
+    double amount = 0.0;
+    uint64_t timestamp = 0;     // Exchange timestamp in milliseconds
+    uint8_t side = 0;           // MarketEvent::Side
+    char tradeId[32] = {};
+};
+
+struct alignas(64) ShmInstrument {
+    char name[64];
+    SeqLock<MarketState> state;     // Top of book and ticker values
+    SeqLock<ShmTrade> lastTrade;
+};
+
+struct ShmMarketDataHeader {
+    static constexpr uint64_t kMagic = 0x44524942444d4431ULL; // "DRIBDMD1"
+    static constexpr uint32_t kVersion = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    std::atomic<uint32_t> count;    // Slots [0, count) have a valid name
+};
+
+inline size_t shmMarketDataSize(uint32_t capacity) {
+    return sizeof(ShmMarketDataHeader) + 64 + capacity * sizeof(ShmInstrument);
+}
+
+inline ShmInstrument* shmMarketDataSlots(ShmMarketDataHeader* header) {
+    auto base = reinterpret_cast<uintptr_t>(header + 1);
+    return reinterpret_cast<ShmInstrument*>((base + 63) & ~uintptr_t(63));
+}
+
+class ShmMarketDataReader {
+public:
+    ShmMarketDataReader() = default;
+    ~ShmMarketDataReader() { close(); }
+    ShmMarketDataReader(const ShmMarketDataReader&) = delete;
+    ShmMarketDataReader& operator=(const ShmMarketDataReader&) = delete;
+
+    // Returns false if the region does not exist or has an unknown layout
+    bool open(const std::string& name = "/deribit_md") {
+        close();
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ShmMarketDataHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+
+        m_header = static_cast<ShmMarketDataHeader*>(mapping);
+        m_size = info.st_size;
+        if (m_header->magic != ShmMarketDataHeader::kMagic ||
+            m_header->version != ShmMarketDataHeader::kVersion ||
+            shmMarketDataSize(m_header->capacity) > m_size) {
+            close();
+            return false;
+        }
+        m_slots = shmMarketDataSlots(m_header);
+        return true;
+    }
+
+    void close() {
+        if (m_header) {
+            munmap(m_header, m_size);
+            m_header = nullptr;
+            m_slots = nullptr;
+        }
+    }
+
+    uint32_t instrumentCount() const {
+        return m_header ? m_header->count.load(std::memory_order_acquire) : 0;
+    }
+
+    const char* instrumentName(uint32_t index) const { return m_slots[index].name; }
+
+    // Index for later lookups; -1 if the instrument is not published (yet)
+    int find(const std::string& instrument) const {
+        uint32_t count = instrumentCount();
+        for (uint32_t i = 0; i < count; ++i) {
+            if (instrument == m_slots[i].name) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Return the seqlock version; compare with a previous value to detect changes.
+    // These retry until they get a consistent copy, so they never return if
+    // the publisher died in the middle of a write.
+    uint64_t readState(int index, MarketState& out) const { return m_slots[index].state.load(out); }
+    uint64_t readLastTrade(int index, ShmTrade& out) const { return m_slots[index].lastTrade.load(out); }
+
+    // Bounded variants: false after maxAttempts torn reads, e.g. when the
+    // publisher crashed mid-write and the slot stays locked
+    static constexpr uint32_t kMaxReadAttempts = 1u << 16;
+    bool tryReadState(int index, MarketState& out, uint64_t& version,
+                      uint32_t maxAttempts = kMaxReadAttempts) const {
+        return tryRead(m_slots[index].state, out, version, maxAttempts);
+    }
+    bool tryReadLastTrade(int index, ShmTrade& out, uint64_t& version,
+                          uint32_t maxAttempts = kMaxReadAttempts) const {
+        return tryRead(m_slots[index].lastTrade, out, version, maxAttempts);
+    }
+
+private:
+    template <typename T>
+    static bool tryRead(const SeqLock<T>& lock, T& out, uint64_t& version, uint32_t maxAttempts) {
+        for (uint32_t attempt = 0; attempt < maxAttempts; ++attempt) {
+            if (lock.tryLoad(out, version)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ShmMarketDataHeader* m_header = nullptr;
+    ShmInstrument* m_slots = nullptr;
+    size_t m_size = 0;
+};
@@ -0,0 +1,86 @@
+#include "shm_publisher.hpp"
+#include "logger.hpp"
+#include <cerrno>
+#include <new>
+
+ShmMarketDataPublisher::ShmMarketDataPublisher(const std::string& name, uint32_t capacity)
+    : m_name(name), m_size(shmMarketDataSize(capacity)) {
+    // Recreate so readers never see a stale layout from a previous run
+    shm_unlink(m_name.c_str());
+    int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        LOG_ERROR_CTX("Shared Memory", "Failed to create {}: {}", m_name, std::strerror(errno));
+        return;
+    }
+    if (ftruncate(fd, m_size) != 0) {
+        LOG_ERROR_CTX("Shared Memory", "Failed to size {}: {}", m_name, std::strerror(errno));
+        ::close(fd);
+        return;
+    }
+    void* mapping = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR_CTX("Shared Memory", "Failed to map {}: {}", m_name, std::strerror(errno));
+        return;
+    }
+
+    // ftruncate zero-fills, so every slot starts out unwritten
+    m_header = static_cast<ShmMarketDataHeader*>(mapping);
+    m_slots = shmMarketDataSlots(m_header);
+    for (uint32_t i = 0; i < capacity; ++i) {
+        new (&m_slots[i]) ShmInstrument{};
+    }
+    m_header->version = ShmMarketDataHeader::kVersion;
+    m_header->capacity = capacity;
+    m_header->count.store(0, std::memory_order_relaxed);
+    // Publishing the magic last marks the region ready for readers
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = ShmMarketDataHeader::kMagic;
+
+    LOG_INFO("Publishing market data to shared memory {}", m_name);
+}
+
+ShmMarketDataPublisher::~ShmMarketDataPublisher() {
+    if (m_header) {
+        munmap(m_header, m_size);
+        shm_unlink(m_name.c_str());
+    }
+}
+
+ShmInstrument* ShmMarketDataPublisher::slotFor(std::string_view instrument) {
+    auto it = m_index.find(instrument);
+    if (it != m_index.end()) {
+        return it->second;
+    }
+
+    ShmInstrument* slot = nullptr;
+    uint32_t index = m_header->count.load(std::memory_order_relaxed);
+    if (index < m_header->capacity && instrument.size() < sizeof(slot->name)) {
+        slot = &m_slots[index];
+        std::memcpy(slot->name, instrument.data(), instrument.size());
+        slot->name[instrument.size()] = '\0';
+        m_header->count.store(index + 1, std::memory_order_release);
+    } else {
+        LOG_WARNING("Shared memory publisher cannot track instrument: {}", instrument);
+    }
+    m_index.emplace(instrument, slot); // Negative results are cached too, so we warn once
+    return slot;
+}
+
+void ShmMarketDataPublisher::publishState(std::string_view instrument, const MarketState& state) {
+    if (!m_header) {
+        return;
+    }
+    if (ShmInstrument* slot = slotFor(instrument)) {
+        slot->state.store(state);
+    }
+}
+
+void ShmMarketDataPublisher::publishTrade(std::string_view instrument, const ShmTrade& trade) {
+    if (!m_header) {
+        return;
+    }
+    if (ShmInstrument* slot = slotFor(instrument)) {
+        slot->lastTrade.store(trade);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <map>
+#include "shm_market_data.hpp"
+
+// Writes decoded market data into the shared-memory region described in
+// shm_market_data.hpp so other local processes can share this client's
+// feed. Single writer: all publish calls must come from the IO thread.
+class ShmMarketDataPublisher {
+public:
+    ShmMarketDataPublisher(const std::string& name = "/deribit_md", uint32_t capacity = 1024);
+    ~ShmMarketDataPublisher();
+    ShmMarketDataPublisher(const ShmMarketDataPublisher&) = delete;
+    ShmMarketDataPublisher& operator=(const ShmMarketDataPublisher&) = delete;
+
+    bool isOpen() const { return m_header != nullptr; }
+
+    void publishState(std::string_view instrument, const MarketState& state);
+    void publishTrade(std::string_view instrument, const ShmTrade& trade);
+
+private:
+    ShmInstrument* slotFor(std::string_view instrument);
+
+    std::string m_name;
+    size_t m_size = 0;
+    ShmMarketDataHeader* m_header = nullptr;
+    ShmInstrument* m_slots = nullptr;
+    std::map<std::string, ShmInstrument*, std::less<>> m_index;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+
+// Minimal assertions for the test executables: failures are reported and
+// counted, and main() returns the count through CHECK_RESULT()
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            ++checkFailures();                                                            \
+        }                                                                                 \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                        \
+    do {                                                                                  \
+        const auto& checkActual = (actual);                                               \
+        const auto& checkExpected = (expected);                                           \
+        if (!(checkActual == checkExpected)) {                                            \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", " #expected \
+                      << ") failed: " << checkActual << " != " << checkExpected << "\n";  \
+            ++checkFailures();                                                            \
+        }                                                                                 \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                           \
+    do {                                                                                  \
+        const double checkActual = (actual);                                              \
+        const double checkExpected = (expected);                                          \
+        if (!(std::fabs(checkActual - checkExpected) <= (tolerance))) {                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_NEAR(" #actual ", " #expected \
+                      << ") failed: " << checkActual << " vs " << checkExpected << "\n";  \
+            ++checkFailures();                                                            \
+        }                                                                                 \
+    } while (0)
+
+#define CHECK_RESULT()                                                                    \
+    (checkFailures() == 0 ? 0 : (std::cerr << checkFailures() << " check(s) failed\n", 1))
@@ -0,0 +1,95 @@
+#include "check.hpp"
+#include "logger.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string encodeVarint(uint64_t value) {
+        char buffer[BinaryLog::kMaxVarint];
+        return std::string(buffer, BinaryLog::putVarint(buffer, value));
+    }
+
+    void testVarintRoundTrip() {
+        std::vector<uint64_t> values = {0, 1, 127, 128, 255, 300, 16383, 16384, (1ull << 32) - 1, 1ull << 32,
+                                        (1ull << 63) - 1, 1ull << 63, std::numeric_limits<uint64_t>::max()};
+        for (unsigned shift = 0; shift < 64; ++shift) {
+            values.push_back((1ull << shift) - 1);
+            values.push_back(1ull << shift);
+        }
+        for (uint64_t value : values) {
+            const std::string encoded = encodeVarint(value);
+            CHECK(encoded.size() <= BinaryLog::kMaxVarint);
+            uint64_t decoded = 0;
+            const char* end = BinaryLog::getVarint(encoded.data(), encoded.data() + encoded.size(), decoded);
+            CHECK(end == encoded.data() + encoded.size());
+            CHECK_EQ(decoded, value);
+        }
+        // Seven bits per byte
+        CHECK_EQ(encodeVarint(127).size(), 1u);
+        CHECK_EQ(encodeVarint(128).size(), 2u);
+        CHECK_EQ(encodeVarint(std::numeric_limits<uint64_t>::max()).size(), 10u);
+    }
+
+    void testTruncatedVarint() {
+        const std::string encoded = encodeVarint(1ull << 40);
+        uint64_t decoded = 0;
+        CHECK(BinaryLog::getVarint(encoded.data(), encoded.data() + encoded.size() - 1, decoded) == nullptr);
+        CHECK(BinaryLog::getVarint(encoded.data(), encoded.data(), decoded) == nullptr);
+        // Continuation bits past 64 bits of payload
+        const std::string overlong(11, '\x80');
+        CHECK(BinaryLog::getVarint(overlong.data(), overlong.data() + overlong.size(), decoded) == nullptr);
+    }
+
+    void testZigzag() {
+        const int64_t values[] = {0, -1, 1, -2, 2, 63, -64, 64, std::numeric_limits<int64_t>::max(),
+                                  std::numeric_limits<int64_t>::min(), -1234567890123LL};
+        for (int64_t value : values) {
+            CHECK_EQ(BinaryLog::unzigzag(BinaryLog::zigzag(value)), value);
+        }
+        // Small magnitudes stay small either side of zero
+        CHECK_EQ(BinaryLog::zigzag(0), 0u);
+        CHECK_EQ(BinaryLog::zigzag(-1), 1u);
+        CHECK_EQ(BinaryLog::zigzag(1), 2u);
+        CHECK_EQ(BinaryLog::zigzag(-64), 127u);
+        CHECK_EQ(encodeVarint(BinaryLog::zigzag(-64)).size(), 1u);
+    }
+
+    // Timestamps are written as zigzag deltas from the previous record and
+    // may go backwards across threads; summing the decoded deltas must give
+    // back every timestamp
+    void testTimestampDeltas() {
+        const int64_t timestamps[] = {1735286400000000000LL, 1735286400000000100LL, 1735286400000000050LL,
+                                      1735286400000000050LL, 1735286401000000000LL};
+        std::string stream;
+        int64_t last = 0;
+        for (int64_t timestamp : timestamps) {
+            stream += encodeVarint(BinaryLog::zigzag(timestamp - last));
+            last = timestamp;
+        }
+
+        const char* in = stream.data();
+        const char* end = stream.data() + stream.size();
+        int64_t timestamp = 0;
+        for (int64_t expected : timestamps) {
+            uint64_t delta = 0;
+            in = BinaryLog::getVarint(in, end, delta);
+            CHECK(in != nullptr);
+            if (!in) {
+                return;
+            }
+            timestamp += BinaryLog::unzigzag(delta);
+            CHECK_EQ(timestamp, expected);
+        }
+        CHECK(in == end);
+    }
+}
+
+int main() {
+    testVarintRoundTrip();
+    testTruncatedVarint();
+    testZigzag();
+    testTimestampDeltas();
+    return CHECK_RESULT();
+}
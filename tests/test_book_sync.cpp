@@ -0,0 +1,227 @@
+#include "check.hpp"
+#include "book_sync.hpp"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace std::chrono_literals;
+
+    const std::string kChannel = "book.BTC-PERPETUAL.100ms";
+
+    struct Requests {
+        std::vector<std::string> channels;
+        BookSynchronizer::RequestSnapshot callback() {
+            return [this](const std::string& channel, const std::string& instrument) {
+                CHECK_EQ(instrument, "BTC-PERPETUAL");
+                channels.push_back(channel);
+            };
+        }
+    };
+
+    BookUpdate update(uint64_t prevChangeId, uint64_t changeId, std::vector<BookLevel> bids,
+                      std::vector<BookLevel> asks = {}) {
+        BookUpdate result;
+        result.changeId = changeId;
+        result.prevChangeId = prevChangeId;
+        result.hasPrevChangeId = true;
+        result.bids = std::move(bids);
+        result.asks = std::move(asks);
+        return result;
+    }
+
+    BookUpdate snapshot(uint64_t changeId, std::vector<BookLevel> bids, std::vector<BookLevel> asks = {}) {
+        BookUpdate result;
+        result.changeId = changeId;
+        result.isSnapshot = true;
+        result.bids = std::move(bids);
+        result.asks = std::move(asks);
+        return result;
+    }
+
+    int64_t bestBidUnits(const OrderBook& book) { return book.bids().begin()->first; }
+
+    void testAppliesChainedUpdates(BookSynchronizer& sync) {
+        CHECK(sync.onUpdate(kChannel, "BTC-PERPETUAL",
+                            snapshot(10, {{BookLevel::SET, 1000, 5}}, {{BookLevel::SET, 1010, 7}})));
+        CHECK(sync.onUpdate(kChannel, "BTC-PERPETUAL", update(10, 11, {{BookLevel::NEW, 1005, 2}})));
+        CHECK(sync.onUpdate(kChannel, "BTC-PERPETUAL",
+                            update(11, 12, {{BookLevel::DELETE, 1000, 0}}, {{BookLevel::CHANGE, 1010, 3}})));
+        const OrderBook* book = sync.book(kChannel);
+        CHECK(book != nullptr);
+        if (book) {
+            CHECK_EQ(book->changeId(), 12u);
+            CHECK_EQ(book->bids().size(), 1u);
+            CHECK_EQ(bestBidUnits(*book), 1005);
+            CHECK_EQ(book->asks().at(1010), 3);
+        }
+    }
+
+    void testGapResyncsAndReplays() {
+        Requests requests;
+        BookSynchronizer sync(requests.callback(), "test=\"gap\"", 0ms);
+        testAppliesChainedUpdates(sync);
+
+        // 13 is lost: 14 does not continue from 12
+        CHECK(!sync.onUpdate(kChannel, "BTC-PERPETUAL", update(13, 14, {{BookLevel::NEW, 1001, 1}})));
+        CHECK(sync.isStale(kChannel));
+        CHECK(sync.book(kChannel) == nullptr);
+        CHECK_EQ(requests.channels.size(), 1u);
+        CHECK(!sync.onUpdate(kChannel, "BTC-PERPETUAL", update(14, 15, {{BookLevel::NEW, 1002, 1}})));
+        CHECK_EQ(requests.channels.size(), 1u);
+
+        // The snapshot is at 14: the buffered 14 is covered, 15 is replayed
+        sync.onSnapshot(kChannel, snapshot(14, {{BookLevel::SET, 1005, 2}, {BookLevel::SET, 1001, 1}}));
+        CHECK(!sync.isStale(kChannel));
+        const OrderBook* book = sync.book(kChannel);
+        CHECK(book != nullptr);
+        if (book) {
+            CHECK_EQ(book->changeId(), 15u);
+            CHECK_EQ(book->bids().size(), 3u);
+            CHECK_EQ(bestBidUnits(*book), 1005);
+            CHECK(book->asks().empty());
+        }
+        CHECK(sync.onUpdate(kChannel, "BTC-PERPETUAL", update(15, 16, {{BookLevel::DELETE, 1005, 0}})));
+        CHECK_EQ(bestBidUnits(*sync.book(kChannel)), 1002);
+    }
+
+    void testDisconnectedSnapshotRetries() {
+        Requests requests;
+        BookSynchronizer sync(requests.callback(), "test=\"retry\"", 0ms);
+        testAppliesChainedUpdates(sync);
+        sync.onUpdate(kChannel, "BTC-PERPETUAL", update(20, 21, {{BookLevel::NEW, 1001, 1}}));
+        CHECK_EQ(requests.channels.size(), 1u);
+
+        // Older than the first buffered update's predecessor: cannot be joined
+        sync.onSnapshot(kChannel, snapshot(18, {{BookLevel::SET, 1000, 1}}));
+        CHECK(sync.isStale(kChannel));
+        CHECK_EQ(requests.channels.size(), 2u);
+
+        sync.onSnapshot(kChannel, snapshot(20, {{BookLevel::SET, 1000, 1}}));
+        CHECK(!sync.isStale(kChannel));
+        CHECK_EQ(sync.book(kChannel)->changeId(), 21u);
+    }
+
+    void testFailedSnapshotRequestsAgain() {
+        Requests requests;
+        BookSynchronizer sync(requests.callback(), "test=\"failed\"", 0ms);
+        testAppliesChainedUpdates(sync);
+        sync.onUpdate(kChannel, "BTC-PERPETUAL", update(20, 21, {}));
+        sync.onSnapshotFailed(kChannel);
+        CHECK_EQ(requests.channels.size(), 1u);
+        sync.onUpdate(kChannel, "BTC-PERPETUAL", update(21, 22, {}));
+        CHECK_EQ(requests.channels.size(), 2u);
+    }
+
+    void testSnapshotRequestsAreRateLimited() {
+        Requests requests;
+        BookSynchronizer sync(requests.callback(), "test=\"rate\"", 100ms);
+        testAppliesChainedUpdates(sync);
+        sync.onUpdate(kChannel, "BTC-PERPETUAL", update(20, 21, {}));
+        CHECK_EQ(requests.channels.size(), 1u);
+
+        // Failing straight away must not turn every update into a request
+        uint64_t changeId = 21;
+        for (int i = 0; i < 50; ++i) {
+            sync.onSnapshotFailed(kChannel);
+            sync.onUpdate(kChannel, "BTC-PERPETUAL", update(changeId, changeId + 1, {}));
+            changeId++;
+        }
+        CHECK_EQ(requests.channels.size(), 1u);
+
+        std::this_thread::sleep_for(120ms);
+        sync.onUpdate(kChannel, "BTC-PERPETUAL", update(changeId, changeId + 1, {}));
+        CHECK_EQ(requests.channels.size(), 2u);
+    }
+
+    // A subscription snapshot resyncs the book while a get_order_book
+    // request is still outstanding. Its late reply must be dropped, and
+    // must not leave the channel thinking a request is in flight: the next
+    // gap has to be able to ask again.
+    void testLateSnapshotAfterSubscriptionResync() {
+        Requests requests;
+        BookSynchronizer sync(requests.callback(), "test=\"late\"", 100ms);
+        testAppliesChainedUpdates(sync);
+        sync.onUpdate(kChannel, "BTC-PERPETUAL", update(20, 21, {}));
+        CHECK_EQ(requests.channels.size(), 1u);
+
+        CHECK(sync.onUpdate(kChannel, "BTC-PERPETUAL", snapshot(30, {{BookLevel::SET, 1020, 4}})));
+        CHECK(!sync.isStale(kChannel));
+
+        sync.onSnapshot(kChannel, snapshot(21, {{BookLevel::SET, 1000, 1}}));
+        CHECK(!sync.isStale(kChannel));
+        CHECK_EQ(sync.book(kChannel)->changeId(), 30u);
+        CHECK_EQ(bestBidUnits(*sync.book(kChannel)), 1020);
+        CHECK(sync.onUpdate(kChannel, "BTC-PERPETUAL", update(30, 31, {})));
+
+        // Gap inside the rate-limit interval: no request yet...
+        CHECK(!sync.onUpdate(kChannel, "BTC-PERPETUAL", update(40, 41, {})));
+        CHECK_EQ(requests.channels.size(), 1u);
+        // ...but the first update after it asks
+        std::this_thread::sleep_for(120ms);
+        CHECK(!sync.onUpdate(kChannel, "BTC-PERPETUAL", update(41, 42, {})));
+        CHECK_EQ(requests.channels.size(), 2u);
+
+        sync.onSnapshot(kChannel, snapshot(41, {{BookLevel::SET, 1030, 1}}));
+        CHECK(!sync.isStale(kChannel));
+        CHECK_EQ(sync.book(kChannel)->changeId(), 42u);
+    }
+
+    void testGroupedChannelsReplaceTheBook() {
+        Requests requests;
+        BookSynchronizer sync(requests.callback(), "test=\"grouped\"", 0ms);
+        const std::string channel = "book.BTC-PERPETUAL.none.10.100ms";
+        BookUpdate first;
+        first.changeId = 5;
+        first.bids = {{BookLevel::SET, 1000, 1}};
+        CHECK(sync.onUpdate(channel, "BTC-PERPETUAL", std::move(first)));
+        BookUpdate second;
+        second.changeId = 9;
+        second.bids = {{BookLevel::SET, 990, 1}};
+        CHECK(sync.onUpdate(channel, "BTC-PERPETUAL", std::move(second)));
+        CHECK_EQ(sync.book(channel)->bids().size(), 1u);
+        CHECK(requests.channels.empty());
+    }
+
+    void testDepthIsBounded() {
+        OrderBook book;
+        BookUpdate full = snapshot(1, {});
+        for (size_t i = 0; i < OrderBook::kMaxDepth + 50; ++i) {
+            full.bids.push_back({BookLevel::SET, static_cast<int64_t>(100000 - i), 1});
+            full.asks.push_back({BookLevel::SET, static_cast<int64_t>(100001 + i), 1});
+        }
+        book.apply(full);
+        CHECK_EQ(book.bids().size(), OrderBook::kMaxDepth);
+        CHECK_EQ(book.asks().size(), OrderBook::kMaxDepth);
+        // The worst levels go, the best stay
+        CHECK_EQ(book.bids().begin()->first, 100000);
+        CHECK_EQ(book.asks().begin()->first, 100001);
+        CHECK_EQ(std::prev(book.bids().end())->first, static_cast<int64_t>(100000 - OrderBook::kMaxDepth + 1));
+    }
+
+    void testResetForgetsBooks() {
+        Requests requests;
+        BookSynchronizer sync(requests.callback(), "test=\"reset\"", 0ms);
+        testAppliesChainedUpdates(sync);
+        sync.onUpdate(kChannel, "BTC-PERPETUAL", update(20, 21, {}));
+        sync.reset();
+        CHECK(!sync.isStale(kChannel));
+        CHECK(sync.book(kChannel) == nullptr);
+        // Without a snapshot a continuing update cannot be trusted
+        CHECK(!sync.onUpdate(kChannel, "BTC-PERPETUAL", update(21, 22, {})));
+        CHECK_EQ(requests.channels.size(), 2u);
+    }
+}
+
+int main() {
+    testGapResyncsAndReplays();
+    testDisconnectedSnapshotRetries();
+    testFailedSnapshotRequestsAgain();
+    testSnapshotRequestsAreRateLimited();
+    testLateSnapshotAfterSubscriptionResync();
+    testGroupedChannelsReplaceTheBook();
+    testDepthIsBounded();
+    testResetForgetsBooks();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,125 @@
+#include "check.hpp"
+#include "conflation_queue.hpp"
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace {
+    void setBid(ConflationQueue& queue, const char* instrument, double price) {
+        queue.update(instrument, [&](MarketState& state) { state.bestBidPrice = price; });
+    }
+
+    void testConflates() {
+        ConflationQueue queue;
+        ConflationQueue::Consumer consumer;
+
+        setBid(queue, "BTC-PERPETUAL", 100.0);
+        setBid(queue, "BTC-PERPETUAL", 101.0);
+        setBid(queue, "ETH-PERPETUAL", 50.0);
+        setBid(queue, "BTC-PERPETUAL", 102.0);
+
+        std::map<std::string, double> seen;
+        size_t calls = 0;
+        const size_t delivered = queue.poll(consumer, [&](const char* instrument, const MarketState& state) {
+            seen[instrument] = state.bestBidPrice;
+            ++calls;
+        });
+        CHECK_EQ(delivered, 2u);
+        CHECK_EQ(calls, 2u);
+        CHECK_EQ(seen["BTC-PERPETUAL"], 102.0);
+        CHECK_EQ(seen["ETH-PERPETUAL"], 50.0);
+
+        // Nothing new
+        CHECK_EQ(queue.poll(consumer, [](const char*, const MarketState&) {}), 0u);
+
+        // Only the instrument that changed is delivered again
+        setBid(queue, "ETH-PERPETUAL", 51.0);
+        seen.clear();
+        CHECK_EQ(queue.poll(consumer, [&](const char* instrument, const MarketState& state) {
+            seen[instrument] = state.bestBidPrice;
+        }), 1u);
+        CHECK_EQ(seen.size(), 1u);
+        CHECK_EQ(seen["ETH-PERPETUAL"], 51.0);
+    }
+
+    void testUpdatesKeepOtherFields() {
+        ConflationQueue queue;
+        queue.update("BTC-PERPETUAL", [](MarketState& state) { state.markPrice = 10.0; });
+        setBid(queue, "BTC-PERPETUAL", 9.5);
+
+        MarketState state;
+        CHECK(queue.latest("BTC-PERPETUAL", state));
+        CHECK_EQ(state.markPrice, 10.0);
+        CHECK_EQ(state.bestBidPrice, 9.5);
+        CHECK(!queue.latest("SOL-PERPETUAL", state));
+    }
+
+    void testIndependentConsumers() {
+        ConflationQueue queue;
+        ConflationQueue::Consumer first;
+        ConflationQueue::Consumer second;
+
+        setBid(queue, "BTC-PERPETUAL", 1.0);
+        CHECK_EQ(queue.poll(first, [](const char*, const MarketState&) {}), 1u);
+        setBid(queue, "BTC-PERPETUAL", 2.0);
+
+        double firstPrice = 0.0;
+        double secondPrice = 0.0;
+        CHECK_EQ(queue.poll(first, [&](const char*, const MarketState& state) { firstPrice = state.bestBidPrice; }), 1u);
+        CHECK_EQ(queue.poll(second, [&](const char*, const MarketState& state) { secondPrice = state.bestBidPrice; }), 1u);
+        CHECK_EQ(firstPrice, 2.0);
+        CHECK_EQ(secondPrice, 2.0);
+    }
+
+    void testRejectsLongNames() {
+        ConflationQueue queue;
+        const std::string name(ConflationQueue::kMaxNameLength, 'X');
+        CHECK(!queue.update(name, [](MarketState&) {}));
+        CHECK_EQ(queue.instrumentCount(), 0u);
+    }
+
+    void testConcurrentConsumerSeesNewest() {
+        ConflationQueue queue;
+        ConflationQueue::Consumer consumer;
+        std::atomic<bool> done{false};
+        constexpr int kUpdates = 100000;
+
+        std::thread producer([&] {
+            for (int i = 1; i <= kUpdates; ++i) {
+                queue.update("BTC-PERPETUAL", [&](MarketState& state) {
+                    state.bestBidPrice = i;
+                    state.bestAskPrice = i;
+                });
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        double last = 0.0;
+        int inconsistent = 0;
+        int backwards = 0;
+        auto check = [&](const char*, const MarketState& state) {
+            inconsistent += state.bestBidPrice != state.bestAskPrice;
+            backwards += state.bestBidPrice < last;
+            last = state.bestBidPrice;
+        };
+        while (!done.load(std::memory_order_acquire)) {
+            queue.poll(consumer, check);
+        }
+        producer.join();
+        queue.poll(consumer, check);
+
+        CHECK_EQ(inconsistent, 0);
+        CHECK_EQ(backwards, 0);
+        CHECK_EQ(last, static_cast<double>(kUpdates));
+    }
+}
+
+int main() {
+    testConflates();
+    testUpdatesKeepOtherFields();
+    testIndependentConsumers();
+    testRejectsLongNames();
+    testConcurrentConsumerSeesNewest();
+    return CHECK_RESULT();
+}
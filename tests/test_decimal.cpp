@@ -0,0 +1,155 @@
+#include "check.hpp"
+#include "decimal.hpp"
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace {
+    using Rounding = Decimal::Rounding;
+
+    Decimal parse(const char* text) {
+        Decimal value;
+        const std::from_chars_result result = Decimal::fromChars(text, text + std::strlen(text), value);
+        CHECK(result.ec == std::errc());
+        CHECK(*result.ptr == '\0');
+        return value;
+    }
+
+    void testParsesExactly() {
+        const Decimal price = parse("64250.5");
+        CHECK_EQ(price.units(), 642505);
+        CHECK_EQ(price.scale(), 1);
+        CHECK_EQ(parse("-0.0001").units(), -1);
+        CHECK_EQ(parse("-0.0001").scale(), 4);
+        CHECK_EQ(parse("42").scale(), 0);
+        CHECK_EQ(parse(".5").units(), 5);
+        CHECK_EQ(parse("7.").units(), 7);
+        CHECK_EQ(parse("7.").scale(), 0);
+        // 0.1 has no exact double; the decimal keeps it
+        CHECK(parse("0.1") == Decimal(1, 1));
+    }
+
+    void testParseStopsAndRejects() {
+        Decimal value(99, 0);
+        const char* text = "1.25x";
+        std::from_chars_result result = Decimal::fromChars(text, text + 5, value);
+        CHECK(result.ec == std::errc());
+        CHECK_EQ(result.ptr - text, 4);
+        CHECK(value == Decimal(125, 2));
+
+        const char* second = "1.2.3";
+        result = Decimal::fromChars(second, second + 5, value);
+        CHECK_EQ(result.ptr - second, 3);
+        CHECK(value == Decimal(12, 1));
+
+        value = Decimal(99, 0);
+        for (const char* bad : {"", "-", ".", "abc", "-x"}) {
+            result = Decimal::fromChars(bad, bad + std::strlen(bad), value);
+            CHECK(result.ec == std::errc::invalid_argument);
+            CHECK(result.ptr == bad);
+        }
+        CHECK(value == Decimal(99, 0));
+
+        const char* tooLong = "99999999999999999999";
+        result = Decimal::fromChars(tooLong, tooLong + std::strlen(tooLong), value);
+        CHECK(result.ec == std::errc::result_out_of_range);
+        const char* tooFine = "0.0000000000000000001";
+        result = Decimal::fromChars(tooFine, tooFine + std::strlen(tooFine), value);
+        CHECK(result.ec == std::errc::result_out_of_range);
+
+        const char* largest = "9223372036854775807";
+        result = Decimal::fromChars(largest, largest + std::strlen(largest), value);
+        CHECK(result.ec == std::errc());
+        CHECK_EQ(value.units(), std::numeric_limits<int64_t>::max());
+    }
+
+    void testFormatsShortest() {
+        CHECK_EQ(Decimal(642505, 1).toString(), "64250.5");
+        CHECK_EQ(Decimal(6425000, 2).toString(), "64250");
+        CHECK_EQ(Decimal(1500, 4).toString(), "0.15");
+        CHECK_EQ(Decimal(-5, 1).toString(), "-0.5");
+        CHECK_EQ(Decimal(-120, 0).toString(), "-120");
+        CHECK_EQ(Decimal(0, 8).toString(), "0");
+        CHECK_EQ(Decimal(1, 18).toString(), "0.000000000000000001");
+        CHECK_EQ(Decimal(std::numeric_limits<int64_t>::min(), 0).toString(), "-9223372036854775808");
+
+        for (const char* text : {"0.0001", "123456.789", "-42.5", "1", "0.00000001"}) {
+            CHECK_EQ(parse(text).toString(), std::string(text));
+        }
+    }
+
+    void testFormatReportsShortBuffer() {
+        char buffer[7];
+        std::to_chars_result result = Decimal(123456, 2).toChars(buffer, buffer + sizeof(buffer));
+        CHECK(result.ec == std::errc());
+        CHECK_EQ(std::string(buffer, result.ptr), "1234.56");
+        char small[4];
+        CHECK(Decimal(123456, 2).toChars(small, small + sizeof(small)).ec == std::errc::value_too_large);
+        CHECK(Decimal(-1, 0).toChars(small, small).ec == std::errc::value_too_large);
+    }
+
+    void testComparesAcrossScales() {
+        CHECK(Decimal(15, 1) == Decimal(150, 2));
+        CHECK(Decimal(15, 1) < Decimal(151, 2));
+        CHECK(Decimal(-15, 1) < Decimal(-149, 2));
+        CHECK(Decimal(1, 0) > Decimal(99999, 5));
+        CHECK(Decimal(2, 0) >= Decimal(20, 1));
+        CHECK(Decimal(2, 0) != Decimal(21, 1));
+    }
+
+    void testRescaleRounds() {
+        CHECK(Decimal(125, 2).rescale(1) == Decimal(13, 1));
+        CHECK(Decimal(-125, 2).rescale(1) == Decimal(-13, 1));
+        CHECK(Decimal(124, 2).rescale(1) == Decimal(12, 1));
+        CHECK(Decimal(129, 2).rescale(1, Rounding::FLOOR) == Decimal(12, 1));
+        CHECK(Decimal(-121, 2).rescale(1, Rounding::FLOOR) == Decimal(-13, 1));
+        CHECK(Decimal(121, 2).rescale(1, Rounding::CEIL) == Decimal(13, 1));
+        CHECK(Decimal(-129, 2).rescale(1, Rounding::CEIL) == Decimal(-12, 1));
+        const Decimal wider = Decimal(5, 1).rescale(4);
+        CHECK_EQ(wider.units(), 5000);
+        CHECK_EQ(wider.scale(), 4);
+    }
+
+    void testRoundsToTick() {
+        const Decimal tick = parse("0.5");
+        const Decimal price = parse("64250.74");
+        CHECK_EQ(price.roundToTick(tick, Rounding::FLOOR).toString(), "64250.5");
+        CHECK_EQ(price.roundToTick(tick, Rounding::CEIL).toString(), "64251");
+        CHECK_EQ(price.roundToTick(tick, Rounding::NEAREST).toString(), "64250.5");
+        CHECK_EQ(parse("64250.75").roundToTick(tick, Rounding::NEAREST).toString(), "64251");
+        CHECK_EQ(price.roundToTick(tick, Rounding::FLOOR).scale(), tick.scale());
+
+        // Lots coarser than the amount's own scale
+        CHECK_EQ(parse("0.0347").roundToTick(parse("0.01"), Rounding::FLOOR).toString(), "0.03");
+        CHECK_EQ(parse("25").roundToTick(parse("10"), Rounding::CEIL).toString(), "30");
+        // Already on the tick, and a zero tick leaves the value alone
+        CHECK(parse("64250.5").roundToTick(tick, Rounding::CEIL) == parse("64250.5"));
+        CHECK(price.roundToTick(Decimal(), Rounding::FLOOR) == price);
+    }
+
+    void testConvertsFromDouble() {
+        CHECK(Decimal::fromDouble(0.1, 8) == Decimal(10000000, 8));
+        CHECK(Decimal::fromDouble(64250.5, 1) == Decimal(642505, 1));
+        CHECK(Decimal::fromDouble(-0.07, 2) == Decimal(-7, 2));
+        CHECK(Decimal::fromDouble(1.005, 2) == Decimal(100, 2) || Decimal::fromDouble(1.005, 2) == Decimal(101, 2));
+
+        const Decimal tick = Decimal::fromShortestDouble(0.0001);
+        CHECK_EQ(tick.units(), 1);
+        CHECK_EQ(tick.scale(), 4);
+        CHECK_EQ(Decimal::fromShortestDouble(2.5).toString(), "2.5");
+        CHECK_EQ(Decimal::fromShortestDouble(10.0).scale(), 0);
+        CHECK_NEAR(parse("123.456").toDouble(), 123.456, 1e-12);
+    }
+}
+
+int main() {
+    testParsesExactly();
+    testParseStopsAndRejects();
+    testFormatsShortest();
+    testFormatReportsShortBuffer();
+    testComparesAcrossScales();
+    testRescaleRounds();
+    testRoundsToTick();
+    testConvertsFromDouble();
+    return CHECK_RESULT();
+}
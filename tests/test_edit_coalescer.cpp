@@ -0,0 +1,203 @@
+#include "check.hpp"
+#include "edit_coalescer.hpp"
+#include "tracing.hpp"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct SentEdit {
+        int id;
+        std::string orderId;
+        std::string amount;
+        std::string price;
+    };
+
+    struct Exchange {
+        int nextId = 100;
+        std::mutex mutex;
+        std::vector<SentEdit> sent;
+
+        EditCoalescer coalescer{[this] { return nextId++; },
+                                [this](int id, const std::string& orderId, const Decimal& amount, const Decimal& price) {
+                                    std::lock_guard<std::mutex> lock(mutex);
+                                    sent.push_back({id, orderId, amount.toString(), price.toString()});
+                                }};
+
+        SentEdit last() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return sent.back();
+        }
+        size_t count() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return sent.size();
+        }
+    };
+
+    Decimal amount(int64_t units) { return Decimal(units, 0); }
+    Decimal price(int64_t units) { return Decimal(units, 1); }
+
+    void testCoalescesBehindInFlightEdit() {
+        Exchange exchange;
+        CHECK(exchange.coalescer.amend("ETH-1", amount(10), price(20000)) == EditCoalescer::Result::SENT);
+        CHECK_EQ(exchange.count(), 1u);
+        CHECK_EQ(exchange.last().id, 100);
+        CHECK_EQ(exchange.last().price, "2000");
+
+        // Three amendments while the first is unacknowledged: later fields win,
+        // zero keeps what an earlier amendment asked for
+        CHECK(exchange.coalescer.amend("ETH-1", amount(11), price(20010)) == EditCoalescer::Result::COALESCED);
+        CHECK(exchange.coalescer.amend("ETH-1", Decimal(), price(20025)) == EditCoalescer::Result::COALESCED);
+        CHECK(exchange.coalescer.amend("ETH-1", amount(12), Decimal()) == EditCoalescer::Result::COALESCED);
+        CHECK_EQ(exchange.count(), 1u);
+        CHECK_EQ(exchange.coalescer.inFlight(), 1u);
+
+        CHECK(exchange.coalescer.onResponse(100, true));
+        CHECK_EQ(exchange.count(), 2u);
+        const SentEdit merged = exchange.last();
+        CHECK_EQ(merged.id, 101);
+        CHECK_EQ(merged.orderId, "ETH-1");
+        CHECK_EQ(merged.amount, "12");
+        CHECK_EQ(merged.price, "2002.5");
+
+        // Nothing pending behind the merged edit: the order is idle again
+        CHECK(exchange.coalescer.onResponse(101, true));
+        CHECK_EQ(exchange.count(), 2u);
+        CHECK_EQ(exchange.coalescer.inFlight(), 0u);
+        CHECK(exchange.coalescer.amend("ETH-1", amount(13), Decimal()) == EditCoalescer::Result::SENT);
+    }
+
+    void testPendingStartsFreshAfterRelease() {
+        Exchange exchange;
+        exchange.coalescer.amend("ETH-1", amount(10), price(20000));
+        exchange.coalescer.amend("ETH-1", amount(11), Decimal());
+        exchange.coalescer.onResponse(100, true);
+        // A new pending edit does not inherit fields of the one already sent
+        exchange.coalescer.amend("ETH-1", Decimal(), price(19990));
+        exchange.coalescer.onResponse(101, true);
+        CHECK_EQ(exchange.count(), 3u);
+        CHECK_EQ(exchange.last().amount, "0");
+        CHECK_EQ(exchange.last().price, "1999");
+    }
+
+    void testRejectionDropsPending() {
+        Exchange exchange;
+        exchange.coalescer.amend("ETH-1", amount(10), price(20000));
+        exchange.coalescer.amend("ETH-1", amount(11), Decimal());
+        CHECK(exchange.coalescer.onResponse(100, false));
+        CHECK_EQ(exchange.count(), 1u);
+        CHECK_EQ(exchange.coalescer.inFlight(), 0u);
+    }
+
+    void testOrdersAreIndependent() {
+        Exchange exchange;
+        CHECK(exchange.coalescer.amend("ETH-1", amount(10), Decimal()) == EditCoalescer::Result::SENT);
+        CHECK(exchange.coalescer.amend("ETH-2", amount(20), Decimal()) == EditCoalescer::Result::SENT);
+        CHECK_EQ(exchange.coalescer.inFlight(), 2u);
+        CHECK(!exchange.coalescer.onResponse(7, true));
+    }
+
+    void testResetForgetsEverything() {
+        Exchange exchange;
+        exchange.coalescer.amend("ETH-1", amount(10), Decimal());
+        exchange.coalescer.amend("ETH-1", amount(11), Decimal());
+        exchange.coalescer.reset();
+        CHECK_EQ(exchange.coalescer.inFlight(), 0u);
+        CHECK(!exchange.coalescer.onResponse(100, true));
+        CHECK(exchange.coalescer.amend("ETH-1", amount(12), Decimal()) == EditCoalescer::Result::SENT);
+    }
+
+    // The merged edit goes out from the IO thread's onResponse(), where no
+    // trace is current; it must still be sent under its amendment's trace
+    void testEditsCarryTheirTrace() {
+        std::vector<uint64_t> traces;
+        int nextId = 1;
+        EditCoalescer coalescer([&] { return nextId++; },
+                                [&](int, const std::string&, const Decimal&, const Decimal&) {
+                                    traces.push_back(Tracer::currentTraceId());
+                                });
+        {
+            TraceContext trace(11);
+            coalescer.amend("ETH-1", amount(10), Decimal());
+        }
+        {
+            TraceContext trace(12);
+            coalescer.amend("ETH-1", amount(11), Decimal());
+        }
+        {
+            TraceContext trace(13);
+            coalescer.amend("ETH-1", amount(12), Decimal());
+        }
+        CHECK_EQ(Tracer::currentTraceId(), 0u);
+        coalescer.onResponse(1, true);
+        CHECK_EQ(Tracer::currentTraceId(), 0u);
+        CHECK_EQ(traces.size(), 2u);
+        CHECK_EQ(traces[0], 11u);
+        CHECK_EQ(traces[1], 13u);
+    }
+
+    // The trading thread amends while the IO thread acknowledges; every
+    // edit sent must carry a value some amend() asked for, and the last
+    // amendment must reach the exchange
+    void testConcurrentAmendAndAck() {
+        std::atomic<int> nextId{1};
+        std::mutex sentMutex;
+        std::vector<std::pair<int, int64_t>> sent;
+        EditCoalescer coalescer([&] { return nextId++; },
+                                [&](int id, const std::string&, const Decimal& amount, const Decimal&) {
+                                    std::lock_guard<std::mutex> lock(sentMutex);
+                                    sent.emplace_back(id, amount.units());
+                                });
+
+        constexpr int64_t kAmendments = 20000;
+        std::atomic<bool> done{false};
+        std::thread io([&] {
+            size_t acked = 0;
+            while (true) {
+                const bool finished = done.load(std::memory_order_acquire);
+                std::vector<int> ids;
+                {
+                    std::lock_guard<std::mutex> lock(sentMutex);
+                    for (; acked < sent.size(); ++acked) {
+                        ids.push_back(sent[acked].first);
+                    }
+                }
+                for (int id : ids) {
+                    coalescer.onResponse(id, true);
+                }
+                if (finished && ids.empty() && coalescer.inFlight() == 0) {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        });
+        for (int64_t i = 1; i <= kAmendments; ++i) {
+            coalescer.amend("ETH-1", Decimal(i, 0), Decimal());
+        }
+        done.store(true, std::memory_order_release);
+        io.join();
+
+        CHECK(!sent.empty());
+        int64_t previous = 0;
+        int badValues = 0;
+        for (const auto& edit : sent) {
+            badValues += edit.second <= previous || edit.second > kAmendments;
+            previous = edit.second;
+        }
+        CHECK_EQ(badValues, 0);
+        CHECK_EQ(sent.back().second, kAmendments);
+    }
+}
+
+int main() {
+    testCoalescesBehindInFlightEdit();
+    testPendingStartsFreshAfterRelease();
+    testRejectionDropsPending();
+    testOrdersAreIndependent();
+    testResetForgetsEverything();
+    testEditsCarryTheirTrace();
+    testConcurrentAmendAndAck();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,126 @@
+#include "check.hpp"
+#include "event_bus.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+    MarketEvent numbered(uint64_t sequence) {
+        MarketEvent event;
+        event.changeId = sequence;
+        return event;
+    }
+
+    void testEveryConsumerSeesEveryEvent() {
+        EventBus bus(8);
+        CHECK_EQ(bus.capacity(), 8u);
+        EventBus::Consumer* first = bus.addConsumer();
+        EventBus::Consumer* second = bus.addConsumer();
+        CHECK(first && second);
+
+        for (uint64_t i = 0; i < 5; ++i) {
+            bus.publish(numbered(i));
+        }
+        CHECK_EQ(bus.lag(*first), 5u);
+
+        std::vector<uint64_t> seen;
+        CHECK_EQ(bus.poll(*first, [&](const MarketEvent& event) { seen.push_back(event.changeId); }), 5u);
+        CHECK_EQ(seen.size(), 5u);
+        for (uint64_t i = 0; i < seen.size(); ++i) {
+            CHECK_EQ(seen[i], i);
+        }
+        CHECK_EQ(bus.lag(*first), 0u);
+
+        // The second consumer is independent and batches are capped
+        size_t batch = bus.poll(*second, [](const MarketEvent&) {}, 3);
+        CHECK_EQ(batch, 3u);
+        CHECK_EQ(bus.lag(*second), 2u);
+        bus.removeConsumer(first);
+        bus.removeConsumer(second);
+    }
+
+    void testLateConsumerStartsAtNextEvent() {
+        EventBus bus(8);
+        bus.publish(numbered(0));
+        EventBus::Consumer* consumer = bus.addConsumer();
+        bus.publish(numbered(1));
+
+        std::vector<uint64_t> seen;
+        bus.poll(*consumer, [&](const MarketEvent& event) { seen.push_back(event.changeId); });
+        CHECK_EQ(seen.size(), 1u);
+        CHECK(!seen.empty() && seen[0] == 1u);
+        bus.removeConsumer(consumer);
+    }
+
+    void testSlotsRunOut() {
+        EventBus bus(8);
+        std::vector<EventBus::Consumer*> consumers;
+        for (size_t i = 0; i < EventBus::kMaxConsumers; ++i) {
+            consumers.push_back(bus.addConsumer());
+            CHECK(consumers.back() != nullptr);
+        }
+        CHECK(bus.addConsumer() == nullptr);
+        bus.removeConsumer(consumers.back());
+        CHECK(bus.addConsumer() != nullptr);
+    }
+
+    // The producer wraps a small ring many times while consumers join,
+    // read and leave; every consumer must see a gap-free sequence
+    void testLosslessUnderConcurrentJoins() {
+        EventBus bus(64);
+        constexpr uint64_t kEvents = 200000;
+        std::atomic<bool> done{false};
+        std::atomic<int> errors{0};
+
+        auto consume = [&](bool stayToEnd) {
+            while (!done.load(std::memory_order_acquire)) {
+                EventBus::Consumer* consumer = bus.addConsumer();
+                if (!consumer) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                uint64_t expected = consumer->cursor();
+                uint64_t received = 0;
+                auto check = [&](const MarketEvent& event) {
+                    errors.fetch_add(event.changeId != expected, std::memory_order_relaxed);
+                    ++expected;
+                    ++received;
+                };
+                while ((stayToEnd || received < 5000) && !done.load(std::memory_order_acquire)) {
+                    if (bus.poll(*consumer, check) == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+                bus.poll(*consumer, check);
+                bus.removeConsumer(consumer);
+            }
+        };
+
+        std::vector<std::thread> consumers;
+        consumers.emplace_back(consume, true);
+        for (int i = 0; i < 3; ++i) {
+            consumers.emplace_back(consume, false);
+        }
+
+        for (uint64_t i = 0; i < kEvents; ++i) {
+            bus.publish(numbered(i));
+        }
+        done.store(true, std::memory_order_release);
+        for (std::thread& thread : consumers) {
+            thread.join();
+        }
+
+        CHECK_EQ(errors.load(), 0);
+        CHECK_EQ(bus.published(), kEvents);
+        // A 64-slot ring cannot absorb the consumers' scheduling delays
+        CHECK(bus.producerStalls() > 0);
+    }
+}
+
+int main() {
+    testEveryConsumerSeesEveryEvent();
+    testLateConsumerStartsAtNextEvent();
+    testSlotsRunOut();
+    testLosslessUnderConcurrentJoins();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,146 @@
+#include "check.hpp"
+#include "log_reader.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    using Decoder = BinaryLog::Decoder;
+
+    void testRender() {
+        CHECK_EQ(BinaryLog::render("Order {} at {}", {"abc", "64250.5"}), std::string("Order abc at 64250.5"));
+        CHECK_EQ(BinaryLog::render("{{literal}} {}", {"x"}), std::string("{literal} x"));
+        CHECK_EQ(BinaryLog::render("{} and {}", {"one"}), std::string("one and {}"));
+        CHECK_EQ(BinaryLog::render("no placeholders", {"extra"}), std::string("no placeholders extra"));
+        CHECK_EQ(BinaryLog::render("lone { and }", {}), std::string("lone { and }"));
+    }
+
+    std::string readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    // The only file in directory; the logger names it after its start time
+    std::string logFileIn(const std::string& directory) {
+        std::string path;
+        if (DIR* dir = opendir(directory.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                if (entry->d_name[0] != '.') {
+                    path = directory + "/" + entry->d_name;
+                }
+            }
+            closedir(dir);
+        }
+        return path;
+    }
+
+    // Everything the logger wrote, decoded back to text
+    void testLoggerRoundTrip() {
+        char directory[] = "/tmp/deribit_log_test_XXXXXX";
+        CHECK(mkdtemp(directory) != nullptr);
+        setenv("DERIBIT_LOG_DIR", directory, 1);
+
+        Logger& logger = Logger::getInstance();
+        const std::string orderId = "ETH-1234";
+        const uint32_t orderFormat = logger.registerFormat(Logger::TRADE, "trader.cpp", 42,
+                                                           "Order {} filled {} of {} at {}, reduce only {}");
+        logger.write(Logger::TRADE, orderFormat, "", orderId, 3u, int64_t(-5), 64250.5, true);
+        const uint32_t braceFormat = logger.registerFormat(Logger::WARNING, "websocket.cpp", 7,
+                                                           "{{raw}} side {} code {}");
+        logger.write(Logger::WARNING, braceFormat, "", 'B', -32602);
+        logger.write(Logger::TRADE, orderFormat, "", std::string_view("BTC-9"), uint64_t(1) << 40, 0, 0.1, false);
+        LOG_ERROR_CTX("Test", "{} missing", "argument", "extra");
+        logger.flush();
+
+        const std::string path = logFileIn(directory);
+        const std::string data = readFile(path);
+        Decoder decoder(data);
+        CHECK(decoder.hasMagic());
+
+        std::vector<std::string> lines;
+        std::vector<Decoder::Message> messages;
+        Decoder::Message message;
+        Decoder::Status status;
+        while ((status = decoder.next(message)) == Decoder::OK) {
+            lines.push_back(message.text());
+            messages.push_back(message);
+        }
+        CHECK_EQ(static_cast<int>(status), static_cast<int>(Decoder::END));
+
+        const std::vector<std::string> expected = {
+            "Logger initialized",
+            "Order ETH-1234 filled 3 of -5 at 64250.5, reduce only true",
+            "{raw} side B code -32602",
+            "Order BTC-9 filled 1099511627776 of 0 at 0.1, reduce only false",
+            "[Test] argument missing extra",
+        };
+        CHECK_EQ(lines.size(), expected.size());
+        for (size_t i = 0; i < lines.size() && i < expected.size(); ++i) {
+            CHECK_EQ(lines[i], expected[i]);
+        }
+        if (messages.size() == expected.size()) {
+            CHECK(messages[1].format != nullptr);
+            CHECK_EQ(static_cast<int>(messages[1].format->level), static_cast<int>(Logger::TRADE));
+            CHECK_EQ(messages[1].format->file, std::string("trader.cpp"));
+            CHECK_EQ(messages[1].format->line, 42u);
+            CHECK_EQ(std::string(BinaryLog::levelString(messages[4].format->level)), std::string("ERROR"));
+            CHECK_EQ(messages[4].format->file, std::string("test_log_reader.cpp"));
+            // Timestamps are unix nanoseconds and never far apart
+            CHECK(messages[1].timestampNs > 1700000000000000000LL);
+            CHECK(messages[4].timestampNs - messages[0].timestampNs < 60000000000LL);
+        }
+
+        // A tail cut mid-record decodes what came before it and then ends
+        const std::string truncated = data.substr(0, data.size() - 3);
+        Decoder partial(truncated);
+        size_t count = 0;
+        while ((status = partial.next(message)) == Decoder::OK) {
+            ++count;
+        }
+        CHECK_EQ(count, expected.size() - 1);
+        CHECK_EQ(static_cast<int>(status), static_cast<int>(Decoder::END));
+
+        std::remove(path.c_str());
+        rmdir(directory);
+    }
+
+    void testCorruptInput() {
+        const std::string notALog = "plain text log line\n";
+        Decoder text(notALog);
+        CHECK(!text.hasMagic());
+
+        std::string unknownRecord(BinaryLog::kMagic, sizeof(BinaryLog::kMagic));
+        unknownRecord += '\x7f';
+        unknownRecord += '\x01';
+        Decoder corrupt(unknownRecord);
+        CHECK(corrupt.hasMagic());
+        Decoder::Message message;
+        CHECK_EQ(static_cast<int>(corrupt.next(message)), static_cast<int>(Decoder::CORRUPT));
+
+        // A MESSAGE whose FORMAT record is missing still decodes
+        std::string orphan(BinaryLog::kMagic, sizeof(BinaryLog::kMagic));
+        orphan += static_cast<char>(BinaryLog::MESSAGE);
+        orphan += '\x09';   // format id
+        orphan += '\x02';   // zigzag delta of +1 ns
+        orphan += '\x00';   // no arguments
+        Decoder decoder(orphan);
+        CHECK_EQ(static_cast<int>(decoder.next(message)), static_cast<int>(Decoder::OK));
+        CHECK(message.format == nullptr);
+        CHECK_EQ(message.timestampNs, 1);
+        CHECK_EQ(message.text(), std::string("<format 9>"));
+        CHECK_EQ(static_cast<int>(decoder.next(message)), static_cast<int>(Decoder::END));
+    }
+}
+
+int main() {
+    testRender();
+    testLoggerRoundTrip();
+    testCorruptInput();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,75 @@
+#include "check.hpp"
+#include "alloc_counter.hpp"
+#include "message_arena.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+    // Frames larger than the arena spill into overflow chunks. Routed
+    // allocations served from those chunks are freed by their owners (here
+    // a vector reallocating) and must be recognised as arena memory rather
+    // than handed to free()
+    void testRoutedOverflowStaysInArena() {
+        MessageArena& arena = MessageArena::forThisThread();
+        const size_t capacity = arena.capacity();
+        const uint64_t overflows = arena.overflows();
+        {
+            MessageArena::Scope frame;
+            const uint64_t before = AllocationCounter::threadAllocations();
+            MessageArena::RouteGlobalAllocations route;
+            std::vector<char> grown;
+            for (size_t i = 0; i < 3 * capacity; ++i) {
+                grown.push_back(static_cast<char>(i));
+            }
+            CHECK(arena.owns(grown.data()));
+            CHECK(arena.owns(grown.data() + grown.size() - 1));
+            CHECK_EQ(AllocationCounter::threadAllocations() - before, 0u);
+        }
+        CHECK_EQ(arena.overflows(), overflows + 1);
+        CHECK_EQ(arena.capacity(), 2 * capacity);
+
+        // Once reset, the chunks are gone and nothing is claimed any more
+        int* heap = new int(1);
+        CHECK(!arena.owns(heap));
+        delete heap;
+    }
+
+    void testLargeDocumentParses() {
+        std::string payload = "{\"jsonrpc\":\"2.0\",\"result\":{\"bids\":[";
+        for (int i = 0; i < 40000; ++i) {
+            payload += (i ? ",[" : "[") + std::to_string(50000 + i) + ".5,1.25]";
+        }
+        payload += "]}}";
+
+        for (int frame = 0; frame < 3; ++frame) {
+            MessageArena::Scope scope;
+            ArenaDocument document(payload);
+            const arena_json& bids = document.json()["result"]["bids"];
+            CHECK_EQ(bids.size(), 40000u);
+            CHECK_EQ(bids[39999][0].get<double>(), 89999.5);
+        }
+    }
+
+    void testSteadyStateHasNoHeapAllocations() {
+        const std::string payload = "{\"params\":{\"channel\":\"ticker.BTC-PERPETUAL.raw\",\"data\":{\"mark_price\":1.5}}}";
+        {
+            // Warm up: sizes the arena for this frame
+            MessageArena::Scope scope;
+            ArenaDocument document(payload);
+        }
+        const uint64_t before = AllocationCounter::threadAllocations();
+        for (int i = 0; i < 100; ++i) {
+            MessageArena::Scope scope;
+            ArenaDocument document(payload);
+            CHECK_EQ(document.json()["params"]["data"]["mark_price"].get<double>(), 1.5);
+        }
+        CHECK_EQ(AllocationCounter::threadAllocations() - before, 0u);
+    }
+}
+
+int main() {
+    testRoutedOverflowStaysInArena();
+    testLargeDocumentParses();
+    testSteadyStateHasNoHeapAllocations();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,118 @@
+#include "check.hpp"
+#include "metrics.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace {
+    uint64_t percentileOf(uint64_t value) {
+        LatencyHistogram histogram;
+        histogram.record(value);
+        return histogram.percentile(0.5);
+    }
+
+    bool contains(const std::string& text, const std::string& line) {
+        return text.find(line + "\n") != std::string::npos;
+    }
+
+    void testBucketBoundaries() {
+        // 0-3 are exact, then four buckets per power of two
+        for (uint64_t v = 0; v <= 7; ++v) {
+            CHECK_EQ(percentileOf(v), v);
+        }
+        CHECK_EQ(percentileOf(8), 9u);
+        CHECK_EQ(percentileOf(9), 9u);
+        CHECK_EQ(percentileOf(10), 11u);
+        CHECK_EQ(percentileOf(15), 15u);
+        CHECK_EQ(percentileOf(16), 19u);
+        CHECK_EQ(percentileOf(1000), 1023u);
+        CHECK_EQ(percentileOf(1024), 1279u);
+        const uint64_t max = std::numeric_limits<uint64_t>::max();
+        CHECK_EQ(percentileOf(max), max);
+    }
+
+    void testPercentiles() {
+        LatencyHistogram histogram;
+        CHECK_EQ(histogram.percentile(0.5), 0u);
+
+        for (uint64_t v = 1; v <= 100; ++v) {
+            histogram.record(v);
+        }
+        CHECK_EQ(histogram.count(), 100u);
+        CHECK_EQ(histogram.sum(), 5050u);
+        CHECK_EQ(histogram.percentile(0.0), 1u);
+        // Rank 50 lands in [48, 55], rank 99 in [96, 111]
+        CHECK_EQ(histogram.percentile(0.5), 55u);
+        CHECK_EQ(histogram.percentile(0.99), 111u);
+        CHECK_EQ(histogram.percentile(1.0), 111u);
+    }
+
+    void testCountAtMost() {
+        LatencyHistogram histogram;
+        for (uint64_t v = 1; v <= 100; ++v) {
+            histogram.record(v);
+        }
+        CHECK_EQ(histogram.countAtMost(0), 0u);
+        CHECK_EQ(histogram.countAtMost(7), 7u);
+        CHECK_EQ(histogram.countAtMost(63), 63u);
+        CHECK_EQ(histogram.countAtMost(127), 100u);
+    }
+
+    void testLabelEscaping() {
+        CHECK_EQ(MetricsRegistry::label("account", "main"), std::string(R"(account="main")"));
+        CHECK_EQ(MetricsRegistry::label("path", "a\"b\\c\nd"), std::string(R"(path="a\"b\\c\nd")"));
+    }
+
+    void testRenderHistogram() {
+        MetricsRegistry& metrics = MetricsRegistry::getInstance();
+        const std::string labels = MetricsRegistry::label("path", "a\"b\\c\nd");
+        LatencyHistogram& histogram = metrics.histogram("test_render_latency_us", labels);
+        for (uint64_t v = 1; v <= 100; ++v) {
+            histogram.record(v);
+        }
+
+        const std::string text = metrics.renderPrometheus();
+        const std::string prefix = R"(test_render_latency_us_bucket{path="a\"b\\c\nd",)";
+        CHECK(contains(text, "# TYPE test_render_latency_us histogram"));
+        CHECK(contains(text, prefix + R"(le="1"} 1)"));
+        CHECK(contains(text, prefix + R"(le="7"} 7)"));
+        CHECK(contains(text, prefix + R"(le="63"} 63)"));
+        CHECK(contains(text, prefix + R"(le="127"} 100)"));
+        CHECK(contains(text, prefix + R"(le="1099511627775"} 100)"));
+        CHECK(contains(text, prefix + R"(le="+Inf"} 100)"));
+        CHECK(contains(text, R"(test_render_latency_us_sum{path="a\"b\\c\nd"} 5050)"));
+        CHECK(contains(text, R"(test_render_latency_us_count{path="a\"b\\c\nd"} 100)"));
+        CHECK(contains(text, "# TYPE test_render_latency_us_quantile gauge"));
+        CHECK(contains(text, R"(test_render_latency_us_quantile{path="a\"b\\c\nd",quantile="0.5"} 55)"));
+        CHECK(contains(text, R"(test_render_latency_us_quantile{path="a\"b\\c\nd",quantile="0.99"} 111)"));
+    }
+
+    void testRenderUnlabelled() {
+        MetricsRegistry& metrics = MetricsRegistry::getInstance();
+        metrics.counter("test_render_events_total").add(3);
+        metrics.gauge("test_render_depth").set(-2);
+        metrics.histogram("test_render_wait_us").record(5);
+
+        const std::string text = metrics.renderPrometheus();
+        CHECK(contains(text, "# TYPE test_render_events_total counter"));
+        CHECK(contains(text, "test_render_events_total 3"));
+        CHECK(contains(text, "test_render_events_per_second 0"));
+        CHECK(contains(text, "test_render_depth -2"));
+        CHECK(contains(text, R"(test_render_wait_us_bucket{le="3"} 0)"));
+        CHECK(contains(text, R"(test_render_wait_us_bucket{le="7"} 1)"));
+        CHECK(contains(text, R"(test_render_wait_us_bucket{le="+Inf"} 1)"));
+        CHECK(contains(text, "test_render_wait_us_sum 5"));
+        CHECK(contains(text, "test_render_wait_us_count 1"));
+        CHECK(contains(text, R"(test_render_wait_us_quantile{quantile="0.5"} 5)"));
+    }
+}
+
+int main() {
+    testBucketBoundaries();
+    testPercentiles();
+    testCountAtMost();
+    testLabelEscaping();
+    testRenderHistogram();
+    testRenderUnlabelled();
+    return CHECK_RESULT();
+}
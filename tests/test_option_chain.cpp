@@ -0,0 +1,115 @@
+#include "check.hpp"
+#include "option_chain.hpp"
+#include <cmath>
+#include <string>
+
+namespace {
+    constexpr double kMsPerYear = 365.0 * 24.0 * 3600.0 * 1000.0;
+
+    double normCdf(double x) {
+        return 0.5 * std::erfc(-x / std::sqrt(2.0));
+    }
+
+    // Black-76 price in coin units, as Deribit quotes inverse options
+    double coinPrice(double forward, double strike, double years, double vol, double callPut) {
+        const double vs = vol * std::sqrt(years);
+        const double d1 = (std::log(forward / strike) + 0.5 * vs * vs) / vs;
+        const double d2 = d1 - vs;
+        return callPut * (forward * normCdf(callPut * d1) - strike * normCdf(callPut * d2)) / forward;
+    }
+
+    void testParseInstrument() {
+        std::string_view currency;
+        uint64_t expiryMs = 0;
+        double strike = 0.0;
+        double callPut = 0.0;
+        CHECK(OptionChainEngine::parseInstrument("BTC-27DEC24-60000-C", currency, expiryMs, strike, callPut));
+        CHECK(currency == "BTC");
+        CHECK_EQ(strike, 60000.0);
+        CHECK_EQ(callPut, 1.0);
+        CHECK_EQ(expiryMs, 1735286400000ull);   // 2024-12-27 08:00 UTC
+
+        CHECK(OptionChainEngine::parseInstrument("ETH-7MAR25-2d5-P", currency, expiryMs, strike, callPut));
+        CHECK_EQ(strike, 2.5);
+        CHECK_EQ(callPut, -1.0);
+
+        // Linear options are quoted in USDC, not in the coin
+        CHECK(!OptionChainEngine::parseInstrument("XRP_USDC-7MAR25-2d5-P", currency, expiryMs, strike, callPut));
+        CHECK(!OptionChainEngine::parseInstrument("BTC-PERPETUAL", currency, expiryMs, strike, callPut));
+        CHECK(!OptionChainEngine::parseInstrument("BTC-27DEC24", currency, expiryMs, strike, callPut));
+    }
+
+    void testSolvesImpliedVols() {
+        OptionChainEngine engine;
+        const uint64_t expiryMs = 1735286400000ull;
+        const uint64_t nowMs = expiryMs - 30ull * 86400000ull;
+        const double years = (expiryMs - nowMs) / kMsPerYear;
+        const double forward = 60000.0;
+
+        const double strikes[] = {40000.0, 55000.0, 60000.0, 65000.0, 90000.0};
+        const double vols[] = {0.9, 0.65, 0.55, 0.6, 0.8};
+        for (int i = 0; i < 5; ++i) {
+            for (double callPut : {1.0, -1.0}) {
+                const std::string name = "BTC-27DEC24-" + std::to_string(static_cast<int>(strikes[i])) +
+                                         (callPut > 0 ? "-C" : "-P");
+                const double mark = coinPrice(forward, strikes[i], years, vols[i], callPut);
+                CHECK(engine.onOptionTicker(name, mark, mark, mark, forward, forward, nowMs));
+            }
+        }
+        engine.recompute();
+
+        const OptionChain* chain = engine.chain("BTC");
+        CHECK(chain != nullptr);
+        if (!chain) {
+            return;
+        }
+        CHECK_EQ(chain->size(), 10u);
+        for (size_t i = 0; i < chain->size(); ++i) {
+            const int strikeIndex = static_cast<int>(i / 2);
+            CHECK_NEAR(chain->iv[i], vols[strikeIndex], 1e-4);
+            CHECK_NEAR(chain->theo[i], chain->mark[i], 1e-6);
+        }
+    }
+
+    void testMissingInputsStayFinite() {
+        OptionChainEngine engine;
+        const uint64_t expiryMs = 1735286400000ull;
+        const uint64_t nowMs = expiryMs - 10ull * 86400000ull;
+        // No mark yet, and no forward yet
+        CHECK(engine.onOptionTicker("BTC-27DEC24-60000-C", 0.0, 0.0, 0.0, 60000.0, 60000.0, nowMs));
+        CHECK(engine.onOptionTicker("BTC-27DEC24-70000-C", 0.01, 0.02, 0.015, 0.0, 0.0, nowMs));
+        CHECK(engine.onOptionTicker("BTC-27DEC24-50000-P", 0.01, 0.02, 0.015, 60000.0, 60000.0, nowMs));
+        engine.recompute();
+
+        const OptionChain* chain = engine.chain("BTC");
+        CHECK(chain != nullptr);
+        if (!chain) {
+            return;
+        }
+        for (size_t i = 0; i < chain->size(); ++i) {
+            CHECK(std::isfinite(chain->iv[i]));
+            CHECK(std::isfinite(chain->theo[i]));
+            CHECK(std::isfinite(chain->delta[i]));
+            CHECK(std::isfinite(chain->gamma[i]));
+        }
+        CHECK_EQ(chain->iv[0], 0.0);
+        CHECK_EQ(chain->iv[1], 0.0);
+        CHECK(chain->iv[2] > 0.0);
+
+        // An index move reprices the whole chain, the unquoted lanes included
+        engine.onIndexPrice("BTC", 61000.0, nowMs + 1000);
+        engine.recompute();
+        for (size_t i = 0; i < chain->size(); ++i) {
+            CHECK(std::isfinite(chain->theo[i]));
+            CHECK(std::isfinite(chain->vega[i]));
+            CHECK(std::isfinite(chain->theta[i]));
+        }
+    }
+}
+
+int main() {
+    testParseInstrument();
+    testSolvesImpliedVols();
+    testMissingInputsStayFinite();
+    return CHECK_RESULT();
+}
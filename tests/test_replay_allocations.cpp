@@ -0,0 +1,118 @@
+#include "check.hpp"
+#include "alloc_counter.hpp"
+#include "market_data_handler.hpp"
+#include "message_arena.hpp"
+#include "tracing.hpp"
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Replays a BTC-PERPETUAL stream in Deribit's wire format (book changes
+// with two dropped updates and their get_order_book answers, public
+// trades, tickers and user.trades) through the dispatch onMessage runs for
+// every frame: arena parsing, then MarketDataHandler for notifications and
+// resync replies. Once a first pass has warmed the arena, the books' node
+// pools and the resync buffers, a second pass must not touch the heap.
+namespace {
+    using namespace std::chrono_literals;
+
+    const char* const kOrderIds[] = {"ETH-4008965600", "ETH-4008965601", "ETH-4008965602", "ETH-4008965603",
+                                     "31187400000", "31187400001", "31187400002", "31187400003"};
+
+    struct Replay {
+        const std::string* snapshotChannel = nullptr;
+        int snapshotRequests = 0;
+        MarketDataHandler handler{[this](const std::string& channel, const std::string&) {
+                                      snapshotChannel = &channel;
+                                      snapshotRequests++;
+                                  },
+                                  "test=\"replay\"", 0ms};
+
+        // Same steps as DeribitWebSocketClient::onMessage for these frames
+        void feed(const std::string& line) {
+            MessageArena::Scope frame;
+            ArenaDocument document(line);
+            const arena_json& msg = document.json();
+            if (msg.contains("method")) {
+                handler.onNotification(msg);
+            } else {
+                CHECK(snapshotChannel != nullptr);
+                if (snapshotChannel) {
+                    handler.onBookSnapshot(*snapshotChannel, msg);
+                }
+            }
+        }
+    };
+
+    std::vector<std::string> readLines(const char* path) {
+        std::vector<std::string> lines;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);) {
+            if (!line.empty()) {
+                lines.push_back(line);
+            }
+        }
+        return lines;
+    }
+
+    void bindOrders(uint64_t traceId) {
+        for (const char* orderId : kOrderIds) {
+            Tracer::getInstance().bindOrder(orderId, traceId);
+        }
+    }
+
+    void checkFinalState(Replay& replay) {
+        const OrderBook* book = replay.handler.books().book("book.BTC-PERPETUAL.100ms");
+        CHECK(book != nullptr);
+        if (!book) {
+            return;
+        }
+        CHECK_EQ(book->changeId(), 52000747u);
+        CHECK_EQ(book->bids().size(), 20u);
+        CHECK_EQ(book->asks().size(), 22u);
+        Decimal price, amount;
+        CHECK(book->bestBid(price, amount));
+        CHECK_EQ(price.toString(), "64242");
+        CHECK(book->bestAsk(price, amount));
+        CHECK_EQ(price.toString(), "64259");
+
+        MarketState state;
+        CHECK(replay.handler.marketState().latest("BTC-PERPETUAL", state));
+        CHECK_EQ(state.bestBidPrice, 64242.0);
+        CHECK(state.markPrice > 0.0);
+        TradeAggregator::Snapshot trades;
+        CHECK(replay.handler.tradeAggregates().snapshot("BTC-PERPETUAL", trades));
+        CHECK(trades.lastPrice > 0.0);
+    }
+
+    void testReplayIsAllocationFree(const std::vector<std::string>& lines) {
+        Replay replay;
+        bindOrders(1);
+        for (const std::string& line : lines) {
+            replay.feed(line);
+        }
+        CHECK_EQ(replay.snapshotRequests, 2);
+        checkFinalState(replay);
+
+        // Binding happens on order acks, not per message
+        bindOrders(2);
+        const uint64_t before = AllocationCounter::threadAllocations();
+        for (const std::string& line : lines) {
+            replay.feed(line);
+        }
+        CHECK_EQ(AllocationCounter::threadAllocations() - before, 0u);
+        CHECK_EQ(replay.snapshotRequests, 4);
+        checkFinalState(replay);
+    }
+}
+
+int main(int argc, char** argv) {
+    CHECK(argc > 1);
+    if (argc > 1) {
+        const std::vector<std::string> lines = readLines(argv[1]);
+        CHECK(lines.size() > 300u);
+        testReplayIsAllocationFree(lines);
+    }
+    return CHECK_RESULT();
+}
@@ -0,0 +1,113 @@
+#include "check.hpp"
+#include "request_scheduler.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Priority = RequestScheduler::Priority;
+
+    RateLimitConfig config(double maxCredits, double refillPerSecond, double requestCost) {
+        RateLimitConfig result;
+        result.maxCredits = maxCredits;
+        result.refillPerSecond = refillPerSecond;
+        result.requestCost = requestCost;
+        return result;
+    }
+
+    void waitForQueued(RequestScheduler& scheduler, size_t count) {
+        while (scheduler.queued() < count) {
+            std::this_thread::yield();
+        }
+    }
+
+    void testBucketCharges() {
+        RequestScheduler scheduler(config(1000.0, 1000.0, 500.0), "test");
+        CHECK(scheduler.tryAcquire(Priority::QUERY));
+        CHECK(scheduler.tryAcquire(Priority::NEW_ORDER));
+        CHECK(!scheduler.tryAcquire(Priority::CANCEL));
+        CHECK(scheduler.availableCredits() < 500.0);
+
+        // 500 credits short at 1000 per second
+        const auto wait = scheduler.untilAffordable();
+        CHECK(wait > std::chrono::milliseconds(400));
+        CHECK(wait <= std::chrono::milliseconds(501));
+    }
+
+    void testRefillsUpToCap() {
+        RequestScheduler scheduler(config(1000.0, 100000.0, 500.0), "test");
+        CHECK(scheduler.tryAcquire(Priority::QUERY));
+        CHECK(scheduler.tryAcquire(Priority::QUERY));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CHECK_EQ(scheduler.untilAffordable().count(), 0);
+        CHECK_NEAR(scheduler.availableCredits(), 1000.0, 1e-9);
+    }
+
+    void testThrottleEmptiesBucket() {
+        RequestScheduler scheduler(config(1000.0, 10.0, 500.0), "test");
+        scheduler.onThrottled();
+        CHECK(scheduler.availableCredits() < 1.0);
+        CHECK(!scheduler.tryAcquire(Priority::CANCEL));
+    }
+
+    void testAcquirePacesBursts() {
+        // Empty bucket paying one request every 20 ms
+        RequestScheduler scheduler(config(500.0, 25000.0, 500.0), "test");
+        scheduler.onThrottled();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 5; ++i) {
+            scheduler.acquire(Priority::QUERY);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        CHECK(elapsed >= std::chrono::milliseconds(95));
+    }
+
+    void testWaitersServedByPriority() {
+        RequestScheduler scheduler(config(500.0, 5000.0, 500.0), "test");
+        scheduler.onThrottled();
+
+        std::atomic<int> order{0};
+        int queryServed = -1;
+        int cancelServed = -1;
+        std::thread query([&] {
+            scheduler.acquire(Priority::QUERY);
+            queryServed = order++;
+        });
+        waitForQueued(scheduler, 1);
+        std::thread cancel([&] {
+            scheduler.acquire(Priority::CANCEL);
+            cancelServed = order++;
+        });
+        waitForQueued(scheduler, 2);
+
+        // Queued work of the same or higher priority is never overtaken
+        CHECK(!scheduler.tryAcquire(Priority::QUERY));
+
+        query.join();
+        cancel.join();
+        CHECK_EQ(cancelServed, 0);
+        CHECK_EQ(queryServed, 1);
+        CHECK_EQ(scheduler.queued(), 0u);
+    }
+
+    void testClassify() {
+        CHECK(RequestScheduler::classify("private/cancel_all") == Priority::CANCEL);
+        CHECK(RequestScheduler::classify("private/close_position") == Priority::RISK_REDUCING);
+        CHECK(RequestScheduler::classify("private/buy") == Priority::NEW_ORDER);
+        CHECK(RequestScheduler::classify("private/sell", true) == Priority::RISK_REDUCING);
+        CHECK(RequestScheduler::classify("public/get_order_book") == Priority::QUERY);
+        CHECK(RequestScheduler::classifyEndpoint("private/sell?amount=10&reduce_only=true") == Priority::RISK_REDUCING);
+        CHECK(RequestScheduler::classifyEndpoint("private/buy?amount=10") == Priority::NEW_ORDER);
+    }
+}
+
+int main() {
+    testBucketCharges();
+    testRefillsUpToCap();
+    testThrottleEmptiesBucket();
+    testAcquirePacesBursts();
+    testWaitersServedByPriority();
+    testClassify();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,121 @@
+#include "check.hpp"
+#include "rx_timestamps.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace {
+    // Connected TCP pair over loopback; software RX stamps work there too
+    struct LoopbackPair {
+        int client = -1;
+        int server = -1;
+
+        LoopbackPair() {
+            const int listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+                listen(listener, 1) != 0 ||
+                getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+                if (listener >= 0) {
+                    close(listener);
+                }
+                return;
+            }
+            client = socket(AF_INET, SOCK_STREAM, 0);
+            if (client >= 0 && connect(client, reinterpret_cast<sockaddr*>(&address), length) == 0) {
+                server = accept(listener, nullptr, nullptr);
+            }
+            close(listener);
+        }
+
+        ~LoopbackPair() {
+            if (client >= 0) {
+                close(client);
+            }
+            if (server >= 0) {
+                close(server);
+            }
+        }
+
+        bool ok() const { return client >= 0 && server >= 0; }
+    };
+
+    // Reads the way asio does: recvmsg() with no control buffer of its own
+    ssize_t readFrom(int fd, char* buffer, size_t size) {
+        iovec iov{buffer, size};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        const ssize_t received = recvmsg(fd, &msg, 0);
+        // The wrapper must hand the msghdr back untouched
+        CHECK(msg.msg_control == nullptr);
+        CHECK_EQ(msg.msg_controllen, 0u);
+        return received;
+    }
+
+    void testStampsLoopbackReads() {
+        CHECK(RxTimestamping::supported());
+        LoopbackPair pair;
+        CHECK(pair.ok());
+        if (!pair.ok()) {
+            return;
+        }
+        CHECK(RxTimestamping::enable(pair.client));
+
+        // The kernel turns stamping on from a deferred work item, so the
+        // first segments after enable() may arrive unstamped
+        const char payload[] = "{\"jsonrpc\":\"2.0\"}";
+        char buffer[64];
+        RxTimestamping::Sample sample;
+        int64_t beforeSend = 0;
+        bool stamped = false;
+        for (int attempt = 0; attempt < 100 && !stamped; ++attempt) {
+            beforeSend = RxTimestamping::nowNs();
+            CHECK_EQ(write(pair.server, payload, sizeof(payload)), static_cast<ssize_t>(sizeof(payload)));
+            CHECK_EQ(readFrom(pair.client, buffer, sizeof(buffer)), static_cast<ssize_t>(sizeof(payload)));
+            CHECK(std::memcmp(buffer, payload, sizeof(payload)) == 0);
+            stamped = RxTimestamping::take(pair.client, sample);
+            if (!stamped) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        CHECK(stamped);
+        CHECK_EQ(sample.fd, pair.client);
+        CHECK(sample.kernelNs >= beforeSend);
+        CHECK(sample.kernelNs <= sample.readNs);
+        CHECK(sample.readNs <= RxTimestamping::nowNs());
+
+        // Each read is handed out once, and only for its own descriptor
+        CHECK(!RxTimestamping::take(pair.client, sample));
+        CHECK_EQ(write(pair.server, payload, sizeof(payload)), static_cast<ssize_t>(sizeof(payload)));
+        CHECK(readFrom(pair.client, buffer, sizeof(buffer)) > 0);
+        CHECK(!RxTimestamping::take(pair.server, sample));
+        CHECK(RxTimestamping::take(pair.client, sample));
+
+        // Disabled descriptors pass straight through
+        RxTimestamping::disable(pair.client);
+        CHECK_EQ(write(pair.server, payload, sizeof(payload)), static_cast<ssize_t>(sizeof(payload)));
+        CHECK(readFrom(pair.client, buffer, sizeof(buffer)) > 0);
+        CHECK(!RxTimestamping::take(pair.client, sample));
+    }
+
+    void testRejectsBadDescriptors() {
+        CHECK(!RxTimestamping::enable(-1));
+        CHECK(!RxTimestamping::enable(1 << 20));
+        RxTimestamping::Sample sample;
+        CHECK(!RxTimestamping::take(-1, sample));
+    }
+}
+
+int main() {
+    testStampsLoopbackReads();
+    testRejectsBadDescriptors();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,81 @@
+#include "check.hpp"
+#include "seqlock.hpp"
+#include <atomic>
+#include <thread>
+
+namespace {
+    // Every field holds the same value, so a torn read is detectable
+    struct Wide {
+        uint64_t values[8];
+    };
+
+    Wide filled(uint64_t value) {
+        Wide wide;
+        for (uint64_t& v : wide.values) {
+            v = value;
+        }
+        return wide;
+    }
+
+    void testVersions() {
+        SeqLock<Wide> lock;
+        CHECK_EQ(lock.version(), 0u);
+
+        lock.store(filled(7));
+        Wide out;
+        CHECK_EQ(lock.load(out), 2u);
+        CHECK_EQ(out.values[0], 7u);
+        CHECK_EQ(out.values[7], 7u);
+
+        lock.store(filled(9));
+        uint64_t version = 0;
+        CHECK(lock.tryLoad(out, version));
+        CHECK_EQ(version, 4u);
+        CHECK_EQ(lock.version(), 4u);
+        CHECK_EQ(out.values[3], 9u);
+    }
+
+    void testNoTornReads() {
+        SeqLock<Wide> lock;
+        std::atomic<bool> done{false};
+        constexpr uint64_t kWrites = 200000;
+
+        std::thread writer([&] {
+            for (uint64_t i = 1; i <= kWrites; ++i) {
+                lock.store(filled(i));
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        uint64_t torn = 0;
+        uint64_t lastSeen = 0;
+        uint64_t backwards = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            Wide out;
+            lock.load(out);
+            for (uint64_t v : out.values) {
+                if (v != out.values[0]) {
+                    ++torn;
+                    break;
+                }
+            }
+            if (out.values[0] < lastSeen) {
+                ++backwards;
+            }
+            lastSeen = out.values[0];
+        }
+        writer.join();
+
+        CHECK_EQ(torn, 0u);
+        CHECK_EQ(backwards, 0u);
+        Wide last;
+        CHECK_EQ(lock.load(last), 2 * kWrites);
+        CHECK_EQ(last.values[0], kWrites);
+    }
+}
+
+int main() {
+    testVersions();
+    testNoTornReads();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,136 @@
+#include "check.hpp"
+#include "shm_publisher.hpp"
+#include "shm_market_data.hpp"
+#include <atomic>
+#include <cstring>
+#include <string>
+
+namespace {
+    // Unique per run so parallel test runs never share a region
+    std::string regionName() {
+        return "/deribit_md_test_" + std::to_string(getpid());
+    }
+
+    MarketState stateAt(double bid, double ask) {
+        MarketState state;
+        state.bestBidPrice = bid;
+        state.bestBidAmount = 10.0;
+        state.bestAskPrice = ask;
+        state.bestAskAmount = 20.0;
+        state.markPrice = (bid + ask) / 2;
+        state.timestamp = 1735300000000;
+        return state;
+    }
+
+    void testRoundTrip() {
+        const std::string name = regionName();
+        ShmMarketDataPublisher publisher(name, 4);
+        CHECK(publisher.isOpen());
+
+        ShmMarketDataReader reader;
+        CHECK(reader.open(name));
+        CHECK_EQ(reader.instrumentCount(), 0u);
+        CHECK_EQ(reader.find("BTC-PERPETUAL"), -1);
+
+        publisher.publishState("BTC-PERPETUAL", stateAt(64242.0, 64259.0));
+        publisher.publishState("ETH-PERPETUAL", stateAt(3400.0, 3401.0));
+        CHECK_EQ(reader.instrumentCount(), 2u);
+        const int btc = reader.find("BTC-PERPETUAL");
+        const int eth = reader.find("ETH-PERPETUAL");
+        CHECK_EQ(btc, 0);
+        CHECK_EQ(eth, 1);
+        CHECK_EQ(std::string(reader.instrumentName(btc)), std::string("BTC-PERPETUAL"));
+        CHECK_EQ(reader.find("SOL-PERPETUAL"), -1);
+
+        MarketState state;
+        const uint64_t first = reader.readState(btc, state);
+        CHECK(first != 0);
+        CHECK_EQ(state.bestBidPrice, 64242.0);
+        CHECK_EQ(state.bestAskPrice, 64259.0);
+        CHECK_EQ(state.timestamp, 1735300000000u);
+
+        // Unchanged slot, unchanged version
+        CHECK_EQ(reader.readState(btc, state), first);
+        publisher.publishState("BTC-PERPETUAL", stateAt(64243.0, 64259.0));
+        const uint64_t second = reader.readState(btc, state);
+        CHECK(second != first);
+        CHECK_EQ(state.bestBidPrice, 64243.0);
+        // Other instruments keep their own version
+        CHECK_EQ(reader.readState(eth, state), first);
+        CHECK_EQ(state.bestBidPrice, 3400.0);
+
+        ShmTrade trade;
+        CHECK_EQ(reader.readLastTrade(btc, trade), 0u);
+        ShmTrade published;
+        published.price = 64250.5;
+        published.amount = 30.0;
+        published.timestamp = 1735300000123;
+        published.side = MarketEvent::SELL;
+        std::strcpy(published.tradeId, "BTC-123456");
+        publisher.publishTrade("BTC-PERPETUAL", published);
+
+        const uint64_t tradeVersion = reader.readLastTrade(btc, trade);
+        CHECK(tradeVersion != 0);
+        CHECK_EQ(trade.price, 64250.5);
+        CHECK_EQ(trade.amount, 30.0);
+        CHECK_EQ(trade.timestamp, 1735300000123u);
+        CHECK_EQ(static_cast<int>(trade.side), static_cast<int>(MarketEvent::SELL));
+        CHECK_EQ(std::string(trade.tradeId), std::string("BTC-123456"));
+
+        uint64_t version = 0;
+        CHECK(reader.tryReadLastTrade(btc, trade, version));
+        CHECK_EQ(version, tradeVersion);
+    }
+
+    void testCapacity() {
+        const std::string name = regionName();
+        ShmMarketDataPublisher publisher(name, 1);
+        ShmMarketDataReader reader;
+        CHECK(reader.open(name));
+
+        publisher.publishState("BTC-PERPETUAL", stateAt(1.0, 2.0));
+        publisher.publishState("ETH-PERPETUAL", stateAt(1.0, 2.0));
+        CHECK_EQ(reader.instrumentCount(), 1u);
+        CHECK_EQ(reader.find("ETH-PERPETUAL"), -1);
+    }
+
+    void testWriterDiedMidWrite() {
+        const std::string name = regionName();
+        ShmMarketDataPublisher publisher(name, 4);
+        publisher.publishState("BTC-PERPETUAL", stateAt(64242.0, 64259.0));
+
+        ShmMarketDataReader reader;
+        CHECK(reader.open(name));
+        const int btc = reader.find("BTC-PERPETUAL");
+        MarketState state;
+        uint64_t version = 0;
+        CHECK(reader.tryReadState(btc, state, version));
+
+        // Leave the slot's sequence odd, as a writer killed inside store() would
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        CHECK(fd >= 0);
+        void* mapping = mmap(nullptr, shmMarketDataSize(4), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        CHECK(mapping != MAP_FAILED);
+        ShmInstrument* slots = shmMarketDataSlots(static_cast<ShmMarketDataHeader*>(mapping));
+        auto* sequence = reinterpret_cast<std::atomic<uint64_t>*>(&slots[btc].state);
+        sequence->store(version + 1, std::memory_order_release);
+
+        CHECK(!reader.tryReadState(btc, state, version, 1000));
+        munmap(mapping, shmMarketDataSize(4));
+    }
+
+    void testMissingRegion() {
+        ShmMarketDataReader reader;
+        CHECK(!reader.open(regionName() + "_missing"));
+        CHECK_EQ(reader.instrumentCount(), 0u);
+    }
+}
+
+int main() {
+    testRoundTrip();
+    testCapacity();
+    testWriterDiedMidWrite();
+    testMissingRegion();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,101 @@
+#include "check.hpp"
+#include "alloc_counter.hpp"
+#include "tracing.hpp"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace {
+    // Complete ("X") spans in the exported trace, by trace id and name
+    std::map<std::pair<uint64_t, std::string>, int> exportedSpans() {
+        const std::string path = "test_tracing_trace.json";
+        CHECK(Tracer::getInstance().exportChromeTrace(path));
+        std::ifstream file(path);
+        const nlohmann::json trace = nlohmann::json::parse(file);
+        std::remove(path.c_str());
+
+        std::map<std::pair<uint64_t, std::string>, int> spans;
+        for (const auto& event : trace["traceEvents"]) {
+            if (event["ph"] == "X") {
+                spans[{event["args"]["trace_id"].get<uint64_t>(), event["name"].get<std::string>()}]++;
+            }
+        }
+        return spans;
+    }
+
+    void testFillsFollowBoundOrders() {
+        Tracer& tracer = Tracer::getInstance();
+        tracer.bindOrder("ETH-1001", 501);
+        tracer.bindOrder("1002", 502);
+        tracer.bindOrder("", 503);
+        tracer.bindOrder("ETH-1004", 0);
+
+        tracer.onFill("ETH-1001", false);
+        tracer.onFill("ETH-1001", true);
+        tracer.onFill("ETH-1001", false);        // Forgotten after its final fill
+        tracer.onFill("1002", false);
+        tracer.onFill("ETH-9999", true);         // Never traced
+
+        auto spans = exportedSpans();
+        CHECK_EQ((spans[{501, "fill"}]), 2);
+        CHECK_EQ((spans[{502, "fill"}]), 1);
+        CHECK_EQ((spans[{503, "fill"}]), 0);
+    }
+
+    // A market order's fills can arrive before the response that binds it
+    void testFillsBeforeBindAreReplayed() {
+        Tracer& tracer = Tracer::getInstance();
+        tracer.onFill("ETH-2001", false);
+        tracer.onFill("ETH-2001", true);
+        tracer.onFill("ETH-2002", false);
+        tracer.bindOrder("ETH-2001", 801);
+        tracer.onFill("ETH-2001", false);        // Done before the bind: not tracked
+        tracer.bindOrder("ETH-2002", 802);
+        tracer.onFill("ETH-2002", true);
+        tracer.bindOrder("ETH-2002", 803);       // Its held fill was consumed
+
+        auto spans = exportedSpans();
+        CHECK_EQ((spans[{801, "fill"}]), 2);
+        CHECK_EQ((spans[{802, "fill"}]), 2);
+        CHECK_EQ((spans[{803, "fill"}]), 0);
+    }
+
+    void testFillsDoNotAllocate() {
+        Tracer& tracer = Tracer::getInstance();
+        // Binding stores the order; the first span creates this thread's ring
+        const std::string orderId = "BTC-PERPETUAL-4008965646";
+        tracer.bindOrder(orderId, 601);
+        tracer.onFill("warm-up", true);
+        tracer.record(601, "warm_up", 0, 0);
+
+        const uint64_t before = AllocationCounter::threadAllocations();
+        for (int i = 0; i < 1000; ++i) {
+            tracer.onFill(orderId, false);
+            tracer.onFill("ETH-unknown-order", false);
+        }
+        tracer.onFill(orderId, true);
+        CHECK_EQ(AllocationCounter::threadAllocations() - before, 0u);
+    }
+
+    void testOldestOpenOrdersAreEvicted() {
+        Tracer& tracer = Tracer::getInstance();
+        for (size_t i = 0; i < 2 * Tracer::kMaxOpenOrders; ++i) {
+            tracer.bindOrder("evict-" + std::to_string(i), 700);
+        }
+        // The newest are still tracked, the first ones are gone
+        tracer.onFill("evict-" + std::to_string(2 * Tracer::kMaxOpenOrders - 1), true);
+        tracer.onFill("evict-0", true);
+        auto spans = exportedSpans();
+        CHECK_EQ((spans[{700, "fill"}]), 1);
+    }
+}
+
+int main() {
+    testFillsFollowBoundOrders();
+    testFillsBeforeBindAreReplayed();
+    testFillsDoNotAllocate();
+    testOldestOpenOrdersAreEvicted();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,186 @@
+#include "check.hpp"
+#include "trade_aggregator.hpp"
+#include <string>
+
+namespace {
+    void testBarRollover() {
+        BarSeries series(1000);
+        CHECK_EQ(series.size(), 0u);
+
+        series.onTrade(1000, 100.0, 1.0);
+        series.onTrade(1500, 110.0, 2.0);
+        series.onTrade(1999, 90.0, 1.0);
+        CHECK_EQ(series.size(), 1u);
+        const OhlcvBar& open = series.bar(0);
+        CHECK_EQ(open.startMs, 1000u);
+        CHECK_EQ(open.open, 100.0);
+        CHECK_EQ(open.high, 110.0);
+        CHECK_EQ(open.low, 90.0);
+        CHECK_EQ(open.close, 90.0);
+        CHECK_EQ(open.volume, 4.0);
+        CHECK_EQ(open.notional, 410.0);
+        CHECK_EQ(open.trades, 3u);
+
+        // The first millisecond of the next interval opens a new bar
+        series.onTrade(2000, 95.0, 3.0);
+        CHECK_EQ(series.size(), 2u);
+        CHECK_EQ(series.bar(0).startMs, 2000u);
+        CHECK_EQ(series.bar(0).open, 95.0);
+        CHECK_EQ(series.bar(0).volume, 3.0);
+        CHECK_EQ(series.bar(1).startMs, 1000u);
+        CHECK_EQ(series.bar(1).close, 90.0);
+    }
+
+    void testEmptyIntervals() {
+        BarSeries series(1000);
+        series.onTrade(2000, 100.0, 1.0);
+        series.onTrade(5300, 101.0, 1.0);
+        // Nothing traded in 3000 or 4000, so no bars exist for them
+        CHECK_EQ(series.size(), 2u);
+        CHECK_EQ(series.bar(0).startMs, 5000u);
+        CHECK_EQ(series.bar(1).startMs, 2000u);
+    }
+
+    void testLateTrades() {
+        BarSeries series(1000);
+        series.onTrade(1000, 100.0, 1.0);
+        series.onTrade(2500, 101.0, 1.0);
+
+        // Out of order but inside the open bar: counted
+        series.onTrade(2100, 99.0, 2.0);
+        CHECK_EQ(series.bar(0).trades, 2u);
+        CHECK_EQ(series.bar(0).volume, 3.0);
+        CHECK_EQ(series.bar(0).low, 99.0);
+        CHECK_EQ(series.bar(0).close, 99.0);
+
+        // Belongs to a closed bar: dropped, closed bar untouched
+        series.onTrade(1200, 50.0, 5.0);
+        CHECK_EQ(series.size(), 2u);
+        CHECK_EQ(series.bar(1).volume, 1.0);
+        CHECK_EQ(series.bar(1).low, 100.0);
+        CHECK_EQ(series.bar(0).volume, 3.0);
+    }
+
+    void testHistoryWraps() {
+        BarSeries series(1000);
+        const size_t total = BarSeries::kHistory + 44;
+        for (size_t i = 0; i < total; ++i) {
+            series.onTrade(i * 1000, 100.0 + i, 1.0);
+        }
+        CHECK_EQ(series.size(), BarSeries::kHistory);
+        CHECK_EQ(series.bar(0).startMs, (total - 1) * 1000);
+        CHECK_EQ(series.bar(BarSeries::kHistory - 1).startMs, (total - BarSeries::kHistory) * 1000);
+    }
+
+    void testRollingWindow() {
+        RollingWindow window(10);
+        CHECK_EQ(window.volume(), 0.0);
+        CHECK_EQ(window.vwap(), 0.0);
+
+        window.onTrade(100000, 100.0, 1.0);
+        window.onTrade(105500, 200.0, 1.0);
+        CHECK_EQ(window.volume(), 2.0);
+        CHECK_NEAR(window.vwap(), 150.0, 1e-9);
+
+        // Second 109 still covers 100..109
+        window.onTrade(109999, 200.0, 2.0);
+        CHECK_EQ(window.volume(), 4.0);
+        CHECK_NEAR(window.vwap(), 175.0, 1e-9);
+
+        // Second 110 covers 101..110: the trade at 100 expires
+        window.onTrade(110000, 300.0, 2.0);
+        CHECK_NEAR(window.volume(), 5.0, 1e-9);
+        CHECK_NEAR(window.vwap(), (200.0 + 400.0 + 600.0) / 5.0, 1e-9);
+
+        // Late but inside the window: counted, and expires with its own second
+        window.onTrade(102000, 100.0, 5.0);
+        CHECK_NEAR(window.volume(), 10.0, 1e-9);
+        CHECK_NEAR(window.vwap(), (1200.0 + 500.0) / 10.0, 1e-9);
+        window.onTrade(113000, 300.0, 1.0);
+        CHECK_NEAR(window.volume(), 6.0, 1e-9);
+        CHECK_NEAR(window.vwap(), (1200.0 + 300.0) / 6.0, 1e-9);
+
+        // Older than the window: dropped
+        window.onTrade(103000, 1.0, 100.0);
+        CHECK_NEAR(window.volume(), 6.0, 1e-9);
+    }
+
+    void testRollingWindowGap() {
+        RollingWindow window(10);
+        window.onTrade(100000, 100.0, 1.0);
+        window.onTrade(101000, 100.0, 1.0);
+        // A gap longer than the window empties it in one step
+        window.onTrade(500000, 250.0, 3.0);
+        CHECK_EQ(window.volume(), 3.0);
+        CHECK_NEAR(window.vwap(), 250.0, 1e-9);
+        // Ten seconds on, the trade at 500 has expired as well
+        window.onTrade(510000, 50.0, 1.0);
+        CHECK_EQ(window.volume(), 1.0);
+        CHECK_NEAR(window.vwap(), 50.0, 1e-9);
+    }
+
+    void testWindowBounds() {
+        CHECK_EQ(RollingWindow(0).seconds(), 1u);
+        CHECK_EQ(RollingWindow(7200).seconds(), static_cast<uint32_t>(RollingWindow::kMaxSeconds));
+    }
+
+    void testAggregatorSnapshot() {
+        TradeAggregator aggregator({1000, 60000}, {10, 60});
+        TradeAggregator::Snapshot snapshot;
+        CHECK(!aggregator.snapshot("BTC-PERPETUAL", snapshot));
+
+        aggregator.onTrade("BTC-PERPETUAL", 60000, 64000.0, 10.0);
+        aggregator.onTrade("BTC-PERPETUAL", 61000, 64100.0, 30.0);
+        aggregator.onTrade("ETH-PERPETUAL", 61000, 3400.0, 1.0);
+
+        CHECK(aggregator.snapshot("BTC-PERPETUAL", snapshot));
+        CHECK_EQ(snapshot.lastTradeMs, 61000u);
+        CHECK_EQ(snapshot.lastPrice, 64100.0);
+        // 1s bars rolled, the 1m bar holds both trades
+        CHECK_EQ(snapshot.bars[0].startMs, 61000u);
+        CHECK_EQ(snapshot.bars[0].volume, 30.0);
+        CHECK_EQ(snapshot.bars[1].startMs, 60000u);
+        CHECK_EQ(snapshot.bars[1].volume, 40.0);
+        CHECK_EQ(snapshot.bars[1].high, 64100.0);
+        const double vwap = (64000.0 * 10.0 + 64100.0 * 30.0) / 40.0;
+        CHECK_NEAR(snapshot.vwap[0], vwap, 1e-6);
+        CHECK_EQ(snapshot.volume[0], 40.0);
+        CHECK_NEAR(snapshot.vwap[1], vwap, 1e-6);
+
+        CHECK(aggregator.snapshot("ETH-PERPETUAL", snapshot));
+        CHECK_EQ(snapshot.volume[1], 1.0);
+
+        const BarSeries* seconds = aggregator.series("BTC-PERPETUAL", 0);
+        CHECK(seconds != nullptr);
+        CHECK_EQ(seconds->intervalMs(), 1000u);
+        CHECK_EQ(seconds->size(), 2u);
+        CHECK(aggregator.series("BTC-PERPETUAL", 2) == nullptr);
+        CHECK(aggregator.series("SOL-PERPETUAL", 0) == nullptr);
+    }
+
+    void testAggregatorLimits() {
+        // Extra intervals and windows beyond the snapshot arrays are dropped
+        TradeAggregator aggregator({1, 2, 3, 4, 5}, {1, 2, 3, 4, 5});
+        CHECK_EQ(aggregator.barIntervalsMs().size(), TradeAggregator::kMaxIntervals);
+        CHECK_EQ(aggregator.windowSeconds().size(), TradeAggregator::kMaxWindows);
+
+        const std::string longName(64, 'X');
+        aggregator.onTrade(longName, 1000, 1.0, 1.0);
+        TradeAggregator::Snapshot snapshot;
+        CHECK(!aggregator.snapshot(longName, snapshot));
+        CHECK(aggregator.series(longName, 0) == nullptr);
+    }
+}
+
+int main() {
+    testBarRollover();
+    testEmptyIntervals();
+    testLateTrades();
+    testHistoryWraps();
+    testRollingWindow();
+    testRollingWindowGap();
+    testWindowBounds();
+    testAggregatorSnapshot();
+    testAggregatorLimits();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,71 @@
+#include "tls_context.hpp"
+#include "logger.hpp"
+
+TLSContextManager::TLSContextManager()
+    : m_context(std::make_shared<boost::asio::ssl::context>(boost::asio::ssl::context::tls_client)) {
+    try {
+        m_context->set_options(
+            boost::asio::ssl::context::default_workarounds |
+            boost::asio::ssl::context::no_sslv2 |
+            boost::asio::ssl::context::no_sslv3 |
+            boost::asio::ssl::context::no_tlsv1 |
+            boost::asio::ssl::context::no_tlsv1_1);
+        m_context->set_default_verify_paths();
+        m_context->set_verify_mode(boost::asio::ssl::verify_peer);
+
+        // Client-side cache only: OpenSSL hands every new session (including
+        // TLS 1.3 tickets that arrive after the handshake) to onNewSession.
+        SSL_CTX* native = m_context->native_handle();
+        SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(native, &TLSContextManager::onNewSession);
+
+        LOG_INFO("TLS context initialized successfully");
+    } catch (const std::exception& e) {
+        LOG_ERROR_CTX("TLS Initialization", "{}", e.what());
+    }
+}
+
+TLSContextManager::~TLSContextManager() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_sessions) {
+        SSL_SESSION_free(entry.second);
+    }
+    m_sessions.clear();
+}
+
+void TLSContextManager::prepareConnection(SSL* ssl, const std::string& host) {
+    SSL_set_tlsext_host_name(ssl, host.c_str());
+    if (SSL_set1_host(ssl, host.c_str()) != 1) {
+        LOG_ERROR_CTX("TLS Initialization", "Failed to enable hostname verification for {}", host);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_sessions.find(host);
+    if (it != m_sessions.end() && SSL_set_session(ssl, it->second) == 1) {
+        LOG_INFO("Attempting TLS session resumption for {}", host);
+    }
+}
+
+bool TLSContextManager::wasResumed(SSL* ssl) const {
+    return SSL_session_reused(ssl) == 1;
+}
+
+int TLSContextManager::onNewSession(SSL* ssl, SSL_SESSION* session) {
+    const char* host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+    if (!host) {
+        return 0;
+    }
+    getInstance().storeSession(host, session);
+    return 1; // We keep the reference
+}
+
+void TLSContextManager::storeSession(const std::string& host, SSL_SESSION* session) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_sessions.find(host);
+    if (it != m_sessions.end()) {
+        SSL_SESSION_free(it->second);
+        it->second = session;
+    } else {
+        m_sessions.emplace(host, session);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <boost/asio/ssl.hpp>
+#include <openssl/ssl.h>
+
+// Process-wide TLS client context shared by every WebSocket connection.
+// The context is created and loaded with the system trust store once, and
+// negotiated sessions are cached per host so reconnects can resume instead
+// of running a full handshake.
+class TLSContextManager {
+public:
+    using context_ptr = std::shared_ptr<boost::asio::ssl::context>;
+
+    static TLSContextManager& getInstance() {
+        static TLSContextManager instance;
+        return instance;
+    }
+
+    context_ptr getContext() const { return m_context; }
+
+    // Sets SNI, enables hostname verification and attaches a cached session
+    // for the host (if any). Must be called before the handshake starts.
+    void prepareConnection(SSL* ssl, const std::string& host);
+
+    bool wasResumed(SSL* ssl) const;
+
+private:
+    TLSContextManager();
+    ~TLSContextManager();
+    TLSContextManager(const TLSContextManager&) = delete;
+    TLSContextManager& operator=(const TLSContextManager&) = delete;
+
+    static int onNewSession(SSL* ssl, SSL_SESSION* session);
+    void storeSession(const std::string& host, SSL_SESSION* session);
+
+    context_ptr m_context;
+    std::map<std::string, SSL_SESSION*> m_sessions;
+    std::mutex m_mutex;
+};
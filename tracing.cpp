@@ -0,0 +1,169 @@
+#include "tracing.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+thread_local uint64_t Tracer::t_traceId = 0;
+thread_local Tracer::ThreadRing* Tracer::t_ring = nullptr;
+
+uint64_t Tracer::newTraceId() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+int64_t Tracer::nowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+Tracer::Tracer() {
+    for (OrderShard& shard : m_orderShards) {
+        shard.orders.reserve(kMaxOpenOrders / kOrderShards + 1);
+    }
+}
+
+Tracer::ThreadRing& Tracer::ring() {
+    if (!t_ring) {
+        // First span on this thread: the only time recording takes a lock
+        auto ring = std::make_shared<ThreadRing>();
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        ring->tid = static_cast<uint32_t>(m_rings.size() + 1);
+        ring->name = "thread " + std::to_string(ring->tid);
+        m_rings.push_back(ring);
+        t_ring = ring.get();
+    }
+    return *t_ring;
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    ThreadRing& threadRing = ring();
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    threadRing.name = name;
+}
+
+void Tracer::record(uint64_t traceId, const char* name, int64_t startNs, int64_t endNs) {
+    ThreadRing& threadRing = ring();
+    const uint64_t written = threadRing.written.load(std::memory_order_relaxed);
+    threadRing.spans[written % kRingCapacity] = Span{traceId, name, startNs, endNs};
+    threadRing.written.store(written + 1, std::memory_order_release);
+}
+
+void Tracer::bindOrder(std::string_view orderId, uint64_t traceId) {
+    if (orderId.empty() || !traceId) {
+        return;
+    }
+    const uint64_t key = orderKey(orderId);
+    OrderShard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const int64_t now = nowNs();
+
+    // Fills that arrived before the ack, oldest first
+    int64_t previousFillNs = 0;
+    bool orderDone = false;
+    for (size_t i = 0; i < kHeldFills; ++i) {
+        HeldFill& fill = shard.held[(shard.heldNext + i) % kHeldFills];
+        if (fill.timeNs == 0 || fill.key != key) {
+            continue;
+        }
+        if (now - fill.timeNs <= kFillHoldNs) {
+            record(traceId, "fill", previousFillNs ? previousFillNs : fill.timeNs, fill.timeNs);
+            previousFillNs = fill.timeNs;
+            orderDone = orderDone || fill.orderDone;
+        }
+        fill.timeNs = 0;
+    }
+    if (orderDone) {
+        shard.orders.erase(key);
+        return;
+    }
+
+    auto inserted = shard.orders.emplace(key, OpenOrder{traceId, now});
+    if (!inserted.second) {
+        inserted.first->second = OpenOrder{traceId, now};
+        return;
+    }
+    shard.age.push_back(key);
+    while (shard.age.size() > kMaxOpenOrders / kOrderShards) {
+        // Resting orders that never fill must not grow the map forever
+        shard.orders.erase(shard.age.front());
+        shard.age.pop_front();
+    }
+}
+
+void Tracer::onFill(std::string_view orderId, bool orderDone) {
+    const uint64_t key = orderKey(orderId);
+    OrderShard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const int64_t now = nowNs();
+    auto it = shard.orders.find(key);
+    if (it == shard.orders.end()) {
+        // Not bound yet, or never traced
+        shard.held[shard.heldNext] = HeldFill{key, now, orderDone};
+        shard.heldNext = (shard.heldNext + 1) % kHeldFills;
+        return;
+    }
+    record(it->second.traceId, "fill", it->second.lastEventNs, now);
+    it->second.lastEventNs = now;
+    if (orderDone) {
+        shard.orders.erase(it);
+    }
+}
+
+bool Tracer::exportChromeTrace(const std::string& path) {
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        rings = m_rings;
+    }
+
+    nlohmann::json events = nlohmann::json::array();
+    size_t spanCount = 0;
+    for (const auto& threadRing : rings) {
+        std::string name;
+        {
+            std::lock_guard<std::mutex> lock(m_ringsMutex);
+            name = threadRing->name;
+        }
+        events.push_back({{"ph", "M"}, {"name", "thread_name"}, {"pid", 1}, {"tid", threadRing->tid},
+                          {"args", {{"name", name}}}});
+
+        const uint64_t written = threadRing->written.load(std::memory_order_acquire);
+        const uint64_t first = written > kRingCapacity ? written - kRingCapacity : 0;
+        std::vector<Span> spans;
+        spans.reserve(written - first);
+        for (uint64_t i = first; i < written; ++i) {
+            spans.push_back(threadRing->spans[i % kRingCapacity]);
+        }
+        // Slots the owner overwrote while we copied hold newer spans; drop them
+        const uint64_t after = threadRing->written.load(std::memory_order_acquire);
+        const uint64_t overwritten = after > kRingCapacity + first ? after - kRingCapacity - first : 0;
+
+        for (size_t i = static_cast<size_t>(std::min<uint64_t>(overwritten, spans.size())); i < spans.size(); ++i) {
+            const Span& span = spans[i];
+            const double startUs = span.startNs / 1000.0;
+            const double endUs = span.endNs / 1000.0;
+            // Thread timeline
+            events.push_back({{"ph", "X"}, {"cat", "order"}, {"name", span.name}, {"pid", 1},
+                              {"tid", threadRing->tid}, {"ts", startUs}, {"dur", endUs - startUs},
+                              {"args", {{"trace_id", span.traceId}}}});
+            // One async track per order
+            events.push_back({{"ph", "b"}, {"cat", "order"}, {"name", span.name}, {"id", span.traceId},
+                              {"pid", 1}, {"tid", threadRing->tid}, {"ts", startUs}});
+            events.push_back({{"ph", "e"}, {"cat", "order"}, {"name", span.name}, {"id", span.traceId},
+                              {"pid", 1}, {"tid", threadRing->tid}, {"ts", endUs}});
+            ++spanCount;
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        LOG_ERROR_CTX("Trace Export", "Failed to open {}", path);
+        return false;
+    }
+    file << nlohmann::json{{"traceEvents", events}, {"displayTimeUnit", "ns"}}.dump();
+    LOG_INFO("Exported {} trace spans from {} threads to {}", spanCount, rings.size(), path);
+    return true;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Per-order latency tracing. Each order gets a trace id; the stages it
+// passes through (decision, risk check, encode, enqueue, socket write,
+// exchange ack, fill) are recorded as spans tagged with that id into a
+// ring buffer owned by the recording thread, so recording never takes a
+// lock. exportChromeTrace() writes Chrome/Perfetto trace JSON: spans
+// appear on their thread's timeline and, grouped by trace id, as one
+// async track per order showing its whole life.
+//
+// The trace id travels with the thread through TraceContext; spans
+// recorded outside any context are dropped, so TRACE_SPAN costs one
+// thread-local read on untraced paths.
+class Tracer {
+public:
+    static constexpr size_t kRingCapacity = 16384;     // Spans kept per thread
+    static constexpr size_t kMaxOpenOrders = 10000;    // Acked orders awaiting fills
+    static constexpr size_t kOrderShards = 16;
+    static constexpr size_t kHeldFills = 32;           // Unmatched fills kept per shard
+    static constexpr int64_t kFillHoldNs = 5000000000; // How long they wait for bindOrder()
+
+    struct Span {
+        uint64_t traceId;
+        const char* name;       // String literal
+        int64_t startNs;
+        int64_t endNs;
+    };
+
+    static Tracer& getInstance() {
+        static Tracer instance;
+        return instance;
+    }
+
+    static uint64_t newTraceId();
+    static uint64_t currentTraceId() { return t_traceId; }
+    static int64_t nowNs();
+
+    // Shown as the thread's name in the trace viewer
+    void setThreadName(const std::string& name);
+
+    void record(uint64_t traceId, const char* name, int64_t startNs, int64_t endNs);
+
+    // The exchange assigned orderId to the traced order; fills on it are
+    // recorded from now on. A market order can fill before its REST
+    // response is parsed: fills held for it are recorded first, at the
+    // time they arrived.
+    void bindOrder(std::string_view orderId, uint64_t traceId);
+    // A trade on orderId: records a fill span since the ack or previous
+    // fill; a final fill forgets the order. A fill on an unknown order is
+    // held for up to kFillHoldNs in case its order is bound later. Called
+    // for every user.trades entry, so it neither allocates nor shares a
+    // lock across all orders.
+    void onFill(std::string_view orderId, bool orderDone);
+
+    // Snapshot of every thread's ring; spans being overwritten while this
+    // runs may be lost
+    bool exportChromeTrace(const std::string& path);
+
+private:
+    struct ThreadRing {
+        uint32_t tid = 0;
+        std::string name;
+        std::vector<Span> spans = std::vector<Span>(kRingCapacity);
+        std::atomic<uint64_t> written{0};
+    };
+
+    struct OpenOrder {
+        uint64_t traceId;
+        int64_t lastEventNs;
+    };
+
+    struct HeldFill {
+        uint64_t key;
+        int64_t timeNs;         // 0 when the slot is free
+        bool orderDone;
+    };
+
+    // Open orders are keyed by a hash of the order id. A collision can
+    // only misattribute a fill span, never affect trading.
+    struct alignas(64) OrderShard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, OpenOrder> orders;
+        std::deque<uint64_t> age;                       // Oldest first, for eviction
+        std::array<HeldFill, kHeldFills> held{};        // Ring; the oldest is overwritten
+        size_t heldNext = 0;
+    };
+
+    Tracer();
+    ThreadRing& ring();
+    static uint64_t orderKey(std::string_view orderId) { return std::hash<std::string_view>{}(orderId); }
+    OrderShard& shardFor(uint64_t key) { return m_orderShards[key % kOrderShards]; }
+
+    static thread_local uint64_t t_traceId;
+    static thread_local ThreadRing* t_ring;
+
+    friend class TraceContext;
+
+    std::mutex m_ringsMutex;
+    std::vector<std::shared_ptr<ThreadRing>> m_rings;   // Outlive their threads for export
+
+    OrderShard m_orderShards[kOrderShards];
+};
+
+// Makes traceId the current trace for this thread until destroyed
+class TraceContext {
+public:
+    explicit TraceContext(uint64_t traceId) : m_previous(Tracer::t_traceId) { Tracer::t_traceId = traceId; }
+    ~TraceContext() { Tracer::t_traceId = m_previous; }
+    TraceContext(const TraceContext&) = delete;
+    TraceContext& operator=(const TraceContext&) = delete;
+
+private:
+    uint64_t m_previous;
+};
+
+// Records the enclosing scope as a span of the current trace
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name)
+        : m_traceId(Tracer::currentTraceId()), m_name(name), m_startNs(m_traceId ? Tracer::nowNs() : 0) {}
+    ~TraceSpan() {
+        if (m_traceId) {
+            Tracer::getInstance().record(m_traceId, m_name, m_startNs, Tracer::nowNs());
+        }
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    uint64_t m_traceId;
+    const char* m_name;
+    int64_t m_startNs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
@@ -0,0 +1,149 @@
+#include "trade_aggregator.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cstring>
+
+void BarSeries::onTrade(uint64_t timestampMs, double price, double amount) {
+    const uint64_t start = timestampMs - timestampMs % m_intervalMs;
+    OhlcvBar* bar = &m_bars[m_head];
+
+    if (m_count == 0 || start > bar->startMs) {
+        // Roll to a new bar; intervals without trades produce no bar
+        if (m_count > 0) {
+            m_head = (m_head + 1) % kHistory;
+        }
+        m_count = std::min(m_count + 1, kHistory);
+        bar = &m_bars[m_head];
+        *bar = OhlcvBar{};
+        bar->startMs = start;
+        bar->open = bar->high = bar->low = price;
+    } else if (start < bar->startMs) {
+        return; // Trade for an already closed bar
+    }
+
+    bar->high = std::max(bar->high, price);
+    bar->low = std::min(bar->low, price);
+    bar->close = price;
+    bar->volume += amount;
+    bar->notional += price * amount;
+    bar->trades++;
+}
+
+RollingWindow::RollingWindow(uint32_t seconds)
+    : m_seconds(std::max<uint32_t>(1, std::min<uint32_t>(seconds, kMaxSeconds))),
+      m_buckets(m_seconds) {
+}
+
+void RollingWindow::advanceTo(uint64_t second) {
+    if (second <= m_latestSecond) {
+        return;
+    }
+    if (second - m_latestSecond >= m_seconds) {
+        std::fill(m_buckets.begin(), m_buckets.end(), Bucket{});
+        m_volume = 0.0;
+        m_notional = 0.0;
+    } else {
+        // Each bucket that falls out of the window is subtracted exactly once
+        for (uint64_t s = m_latestSecond + 1; s <= second; ++s) {
+            Bucket& expired = m_buckets[s % m_seconds];
+            m_volume -= expired.volume;
+            m_notional -= expired.notional;
+            expired = Bucket{};
+        }
+        // Guard against floating-point drift leaving tiny negative sums
+        if (m_volume < 1e-12) {
+            m_volume = 0.0;
+            m_notional = 0.0;
+        }
+    }
+    m_latestSecond = second;
+}
+
+void RollingWindow::onTrade(uint64_t timestampMs, double price, double amount) {
+    const uint64_t second = timestampMs / 1000;
+    advanceTo(second);
+    if (second + m_seconds <= m_latestSecond) {
+        return; // Older than the window
+    }
+
+    Bucket& bucket = m_buckets[second % m_seconds];
+    bucket.second = second;
+    bucket.volume += amount;
+    bucket.notional += price * amount;
+    m_volume += amount;
+    m_notional += price * amount;
+}
+
+TradeAggregator::TradeAggregator(std::vector<uint64_t> barIntervalsMs, std::vector<uint32_t> windowSeconds)
+    : m_barIntervalsMs(std::move(barIntervalsMs)),
+      m_windowSeconds(std::move(windowSeconds)),
+      m_instruments(new Instrument[kMaxInstruments]) {
+    m_barIntervalsMs.resize(std::min(m_barIntervalsMs.size(), kMaxIntervals));
+    m_windowSeconds.resize(std::min(m_windowSeconds.size(), kMaxWindows));
+}
+
+TradeAggregator::Instrument* TradeAggregator::instrumentFor(std::string_view instrument) {
+    auto it = m_index.find(instrument);
+    if (it != m_index.end()) {
+        return it->second;
+    }
+
+    Instrument* entry = nullptr;
+    size_t index = m_count.load(std::memory_order_relaxed);
+    if (index < kMaxInstruments && instrument.size() < sizeof(entry->name)) {
+        entry = &m_instruments[index];
+        std::memcpy(entry->name, instrument.data(), instrument.size());
+        entry->name[instrument.size()] = '\0';
+        for (uint64_t interval : m_barIntervalsMs) {
+            entry->bars.emplace_back(interval);
+        }
+        for (uint32_t seconds : m_windowSeconds) {
+            entry->windows.emplace_back(seconds);
+        }
+        m_count.store(index + 1, std::memory_order_release);
+    } else {
+        LOG_WARNING("Trade aggregator cannot track instrument: {}", instrument);
+    }
+    m_index.emplace(instrument, entry);
+    return entry;
+}
+
+void TradeAggregator::onTrade(std::string_view instrument, uint64_t timestampMs, double price, double amount) {
+    Instrument* entry = instrumentFor(instrument);
+    if (!entry) {
+        return;
+    }
+
+    Snapshot snapshot;
+    snapshot.lastTradeMs = timestampMs;
+    snapshot.lastPrice = price;
+    for (size_t i = 0; i < entry->bars.size(); ++i) {
+        entry->bars[i].onTrade(timestampMs, price, amount);
+        snapshot.bars[i] = entry->bars[i].bar(0);
+    }
+    for (size_t i = 0; i < entry->windows.size(); ++i) {
+        entry->windows[i].onTrade(timestampMs, price, amount);
+        snapshot.vwap[i] = entry->windows[i].vwap();
+        snapshot.volume[i] = entry->windows[i].volume();
+    }
+    entry->published.store(snapshot);
+}
+
+const BarSeries* TradeAggregator::series(std::string_view instrument, size_t intervalIndex) const {
+    auto it = m_index.find(instrument);
+    if (it == m_index.end() || !it->second || intervalIndex >= it->second->bars.size()) {
+        return nullptr;
+    }
+    return &it->second->bars[intervalIndex];
+}
+
+bool TradeAggregator::snapshot(const std::string& instrument, Snapshot& out) const {
+    size_t count = m_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        if (instrument == m_instruments[i].name) {
+            m_instruments[i].published.load(out);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "seqlock.hpp"
+
+struct OhlcvBar {
+    uint64_t startMs = 0;
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+    double volume = 0.0;
+    double notional = 0.0;      // Sum of price * amount, for the bar VWAP
+    uint32_t trades = 0;
+};
+
+// Fixed-size history of bars for one interval. A trade updates the open
+// bar in place or rolls to a new one; nothing is ever rescanned.
+class BarSeries {
+public:
+    static constexpr size_t kHistory = 256;
+
+    explicit BarSeries(uint64_t intervalMs = 60000) : m_intervalMs(intervalMs) {}
+
+    void onTrade(uint64_t timestampMs, double price, double amount);
+
+    uint64_t intervalMs() const { return m_intervalMs; }
+    size_t size() const { return m_count; }
+    // ago = 0 is the open bar, 1 the last closed bar, ...
+    const OhlcvBar& bar(size_t ago) const { return m_bars[(m_head + kHistory - ago) % kHistory]; }
+
+private:
+    uint64_t m_intervalMs;
+    OhlcvBar m_bars[kHistory];
+    size_t m_head = 0;
+    size_t m_count = 0;
+};
+
+// Volume and VWAP over a trailing window, kept as per-second buckets with
+// running sums. Expired buckets are subtracted as time advances, so each
+// bucket is added and removed once and the cost per trade is bounded by a
+// constant regardless of trade rate.
+class RollingWindow {
+public:
+    static constexpr size_t kMaxSeconds = 3600;
+
+    explicit RollingWindow(uint32_t seconds = 60);
+
+    void onTrade(uint64_t timestampMs, double price, double amount);
+
+    uint32_t seconds() const { return m_seconds; }
+    double volume() const { return m_volume; }
+    double vwap() const { return m_volume > 0.0 ? m_notional / m_volume : 0.0; }
+
+private:
+    struct Bucket {
+        uint64_t second = 0;
+        double volume = 0.0;
+        double notional = 0.0;
+    };
+
+    void advanceTo(uint64_t second);
+
+    uint32_t m_seconds;
+    std::vector<Bucket> m_buckets;
+    uint64_t m_latestSecond = 0;
+    double m_volume = 0.0;
+    double m_notional = 0.0;
+};
+
+// Per-instrument OHLCV bars at several intervals plus rolling VWAP/volume
+// windows, updated incrementally from the trade tape on the IO thread.
+// Other threads read the newest values through snapshot().
+class TradeAggregator {
+public:
+    static constexpr size_t kMaxInstruments = 256;
+    static constexpr size_t kMaxIntervals = 4;
+    static constexpr size_t kMaxWindows = 4;
+
+    struct Snapshot {
+        uint64_t lastTradeMs = 0;
+        double lastPrice = 0.0;
+        OhlcvBar bars[kMaxIntervals];       // Open bar per configured interval
+        double vwap[kMaxWindows] = {};
+        double volume[kMaxWindows] = {};
+    };
+
+    TradeAggregator(std::vector<uint64_t> barIntervalsMs = {1000, 60000, 300000, 3600000},
+                    std::vector<uint32_t> windowSeconds = {10, 60, 300, 3600});
+
+    // IO thread only
+    void onTrade(std::string_view instrument, uint64_t timestampMs, double price, double amount);
+    // Full bar history; IO thread only
+    const BarSeries* series(std::string_view instrument, size_t intervalIndex) const;
+
+    // Any thread
+    bool snapshot(const std::string& instrument, Snapshot& out) const;
+    const std::vector<uint64_t>& barIntervalsMs() const { return m_barIntervalsMs; }
+    const std::vector<uint32_t>& windowSeconds() const { return m_windowSeconds; }
+
+private:
+    struct Instrument {
+        char name[64] = {};
+        std::vector<BarSeries> bars;
+        std::vector<RollingWindow> windows;
+        SeqLock<Snapshot> published;
+    };
+
+    Instrument* instrumentFor(std::string_view instrument);
+
+    std::vector<uint64_t> m_barIntervalsMs;
+    std::vector<uint32_t> m_windowSeconds;
+    std::unique_ptr<Instrument[]> m_instruments;
+    std::atomic<size_t> m_count{0};
+    std::map<std::string, Instrument*, std::less<>> m_index; // IO thread only
+};
@@ -5,6 +5,9 @@
 #include <iostream>
 #include "trader.hpp"
 #include "logger.hpp" 
+#include "metrics.hpp"
+#include "request_scheduler.hpp"
+#include "tracing.hpp"
 using json = nlohmann::json;
 
 using namespace std;
@@ -21,9 +24,36 @@ static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::stri
     }
 }
 
-Trader::Trader(const std::string& clientId, const std::string& clientSecret)
-    : clientId(clientId), clientSecret(clientSecret) {
-    LOG_INFO("Trader initialized with client ID: " + clientId);
+static void lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<std::mutex*>(userptr)[data].lock();
+}
+
+static void unlockShare(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<std::mutex*>(userptr)[data].unlock();
+}
+
+Trader::Trader(const std::string& clientId, const std::string& clientSecret, const std::string& account)
+    : clientId(clientId), clientSecret(clientSecret), account(account) {
+    inFlightRequests = &MetricsRegistry::getInstance().gauge("deribit_rest_in_flight_requests",
+                                                             MetricsRegistry::label("account", account));
+    share = curl_share_init();
+    if (share) {
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, shareLocks);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    } else {
+        LOG_ERROR_CTX("Trader", "Failed to initialize CURL share handle");
+    }
+    LOG_INFO("Trader initialized with client ID: {}", clientId);
+}
+
+Trader::~Trader() {
+    if (share) {
+        curl_share_cleanup(share);
+    }
 }
 
 string Trader::authenticate() {
@@ -40,6 +70,10 @@ string Trader::authenticate() {
     CURLcode res;
     std::string readBuffer;
 
+    if (scheduler) {
+        scheduler->acquire(RequestScheduler::Priority::QUERY);
+    }
+
     curl_global_init(CURL_GLOBAL_DEFAULT);
     curl = curl_easy_init();
 
@@ -47,6 +81,7 @@ string Trader::authenticate() {
         // Set up the curl request
         curl_easy_setopt(curl, CURLOPT_URL, authUrl.c_str());
         curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
 
         // Set up callback to capture response
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
@@ -58,7 +93,7 @@ string Trader::authenticate() {
         // Check for errors
         if (res != CURLE_OK) {
             std::string error_msg = "Authentication failed: " + std::string(curl_easy_strerror(res));
-            LOG_ERROR_CTX("Authentication", error_msg);
+            LOG_ERROR_CTX("Authentication", "{}", error_msg);
             curl_easy_cleanup(curl);
             curl_global_cleanup();
             throw std::runtime_error(error_msg);
@@ -82,21 +117,21 @@ string Trader::authenticate() {
             }
             else {
                 std::string error_msg = "Invalid authentication response";
-                LOG_ERROR_CTX("Authentication", error_msg);
+                LOG_ERROR_CTX("Authentication", "{}", error_msg);
                 END_MEASUREMENT(authentication);
                 throw std::runtime_error(error_msg);
             }
         }
         catch (const nlohmann::json::exception& e) {
             std::string error_msg = "JSON parsing error: " + std::string(e.what());
-            LOG_ERROR_CTX("Authentication", error_msg);
+            LOG_ERROR_CTX("Authentication", "{}", error_msg);
             END_MEASUREMENT(authentication);
             throw std::runtime_error(error_msg);
         }
     }
     else {
         std::string error_msg = "Failed to initialize CURL";
-        LOG_ERROR_CTX("Authentication", error_msg);
+        LOG_ERROR_CTX("Authentication", "{}", error_msg);
         END_MEASUREMENT(authentication);
         throw std::runtime_error(error_msg);
     }
@@ -104,7 +139,17 @@ string Trader::authenticate() {
 
 json Trader::sendRequest(const std::string &endpoint) {
     START_MEASUREMENT(api_request);
-    LOG_INFO("Sending request to: " + endpoint);
+    LOG_INFO("Sending request to: {}", endpoint);
+
+    MethodMetrics& methodSeries = metricsForMethod(std::string_view(endpoint).substr(0, endpoint.find('?')));
+    methodSeries.requests->add();
+    inFlightRequests->add(1);
+    ScopedLatency latency(*methodSeries.latency);
+    struct InFlightGuard {
+        MetricGauge& gauge;
+        ~InFlightGuard() { gauge.add(-1); }
+    } inFlightGuard{*inFlightRequests};
+    MetricCounter& errors = *methodSeries.errors;
     
     if (accessToken.empty()) {
         LOG_INFO("No access token found, authenticating first");
@@ -115,7 +160,7 @@ json Trader::sendRequest(const std::string &endpoint) {
     std::string response_string;
     if (!curl) {
         std::string error_msg = "Failed to initialize curl";
-        LOG_ERROR_CTX("API Request", error_msg);
+        LOG_ERROR_CTX("API Request", "{}", error_msg);
         END_MEASUREMENT(api_request);
         std::cerr << error_msg << std::endl;
         return json::object();  // Return empty JSON object
@@ -123,25 +168,44 @@ json Trader::sendRequest(const std::string &endpoint) {
 
     // Set up headers
     struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, ("Authorization: Bearer " + accessToken).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    std::string url = baseUrl + endpoint;
+    std::string url;
+    {
+        TRACE_SPAN("encode");
+        headers = curl_slist_append(headers, ("Authorization: Bearer " + accessToken).c_str());
+        headers = curl_slist_append(headers, "Content-Type: application/json");
+        url = baseUrl + endpoint;
+    }
+    if (scheduler) {
+        TRACE_SPAN("enqueue");
+        scheduler->acquire(RequestScheduler::classifyEndpoint(endpoint));
+    }
     // std::string post_fields = params.dump();
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_SHARE, share);
     // curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_fields.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
 
+    const int64_t performStartNs = Tracer::nowNs();
     CURLcode res = curl_easy_perform(curl);
+    if (const uint64_t traceId = Tracer::currentTraceId()) {
+        // Connection reuse or setup, then request write through response
+        curl_off_t pretransferUs = 0;
+        curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &pretransferUs);
+        const int64_t writeStartNs = performStartNs + static_cast<int64_t>(pretransferUs) * 1000;
+        Tracer& tracer = Tracer::getInstance();
+        tracer.record(traceId, "connect", performStartNs, writeStartNs);
+        tracer.record(traceId, "exchange_ack", writeStartNs, Tracer::nowNs());
+    }
     curl_slist_free_all(headers);
     curl_easy_cleanup(curl);
 
     if (res != CURLE_OK) {
         std::string error_msg = "curl_easy_perform() failed: " + std::string(curl_easy_strerror(res));
-        LOG_ERROR_CTX("API Request", error_msg);
+        errors.add();
+        LOG_ERROR_CTX("API Request", "{}", error_msg);
         END_MEASUREMENT(api_request);
         std::cerr << error_msg << std::endl;
         return json::object();  // Return empty JSON object
@@ -149,15 +213,62 @@ json Trader::sendRequest(const std::string &endpoint) {
 
     try {
         json jsonResponse = json::parse(response_string);
-        LOG_INFO("Response received from: " + endpoint);
+        if (scheduler && jsonResponse.contains("error") &&
+            jsonResponse["error"].value("code", 0) == RequestScheduler::kTooManyRequests) {
+            scheduler->onThrottled();
+        }
+        if (const uint64_t traceId = Tracer::currentTraceId()) {
+            auto result = jsonResponse.find("result");
+            if (result != jsonResponse.end() && result->is_object() && result->contains("order")) {
+                Tracer::getInstance().bindOrder((*result)["order"].value("order_id", ""), traceId);
+            }
+        }
+        LOG_INFO("Response received from: {}", endpoint);
         END_MEASUREMENT(api_request);
         return jsonResponse;  // Return the full JSON response
     }
     catch (const json::exception& e) {
         std::string error_msg = "JSON parsing error: " + std::string(e.what());
-        LOG_ERROR_CTX("API Request", error_msg);
+        errors.add();
+        LOG_ERROR_CTX("API Request", "{}", error_msg);
         END_MEASUREMENT(api_request);
         std::cerr << error_msg << std::endl;
         return json::object();  // Return empty JSON object
     }
-}
\ No newline at end of file
+}
+Trader::MethodMetrics& Trader::metricsForMethod(std::string_view method) {
+    auto it = methodMetrics.find(method);
+    if (it != methodMetrics.end()) {
+        return it->second;
+    }
+
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    const std::string labels = MetricsRegistry::label("account", account) + "," +
+                               MetricsRegistry::label("method", method);
+    MethodMetrics entry;
+    entry.requests = &metrics.counter("deribit_rest_requests_total", labels);
+    entry.errors = &metrics.counter("deribit_rest_errors_total", labels);
+    entry.latency = &metrics.histogram("deribit_rest_request_latency_us", labels);
+    return methodMetrics.emplace(std::string(method), entry).first->second;
+}
+
+const InstrumentSpec& Trader::instrumentSpec(const std::string& instrument) {
+    auto it = instrumentSpecs.find(instrument);
+    if (it != instrumentSpecs.end()) {
+        return it->second;
+    }
+
+    json response = sendRequest("public/get_instrument?instrument_name=" + instrument);
+    if (!response.contains("result") || !response["result"].is_object()) {
+        throw std::runtime_error("Unknown instrument: " + instrument);
+    }
+    const json& result = response["result"];
+
+    // The exchange sends these as JSON numbers; recover the decimal they were written as
+    InstrumentSpec spec;
+    spec.tickSize = Decimal::fromShortestDouble(result.value("tick_size", 0.0));
+    spec.minTradeAmount = Decimal::fromShortestDouble(result.value("min_trade_amount", 0.0));
+    LOG_INFO("Instrument {}: tick size {}, min trade amount {}", instrument, spec.tickSize.toString(),
+             spec.minTradeAmount.toString());
+    return instrumentSpecs.emplace(instrument, spec).first->second;
+}
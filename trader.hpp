@@ -2,23 +2,66 @@
 #define TRADER_HPP
 
 #include <string>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <curl/curl.h>
 #include <nlohmann/json.hpp> 
+#include "decimal.hpp"
 using json = nlohmann::json;
 
+class RequestScheduler;
+class MetricCounter;
+class MetricGauge;
+class LatencyHistogram;
+
+// Order granularity of an instrument from public/get_instrument
+struct InstrumentSpec {
+    Decimal tickSize;
+    Decimal minTradeAmount;
+};
+
 // Forward declaration of WriteCallback function
 static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s);
 
 class Trader{
 public:
-    Trader(const std::string& clientId, const std::string& clientSecret);
+    Trader(const std::string& clientId, const std::string& clientSecret, const std::string& account = "main");
+    ~Trader();
+    Trader(const Trader&) = delete;
+    Trader& operator=(const Trader&) = delete;
 
     std::string authenticate();
     json sendRequest(const std::string &endpoint);
+    // Fetched once per instrument and cached; throws if the exchange has no such instrument
+    const InstrumentSpec& instrumentSpec(const std::string& instrument);
+
+    // Optional: pace requests through the account's shared credit bucket
+    void setScheduler(RequestScheduler* scheduler) { this->scheduler = scheduler; }
 
 private:
+    // Series for one REST method, registered on its first request
+    struct MethodMetrics {
+        MetricCounter* requests = nullptr;
+        MetricCounter* errors = nullptr;
+        LatencyHistogram* latency = nullptr;
+    };
+    MethodMetrics& metricsForMethod(std::string_view method);
+
     std::string clientId;
     std::string clientSecret;
     std::string accessToken;
+    // Shared DNS cache, TLS sessions and connection pool so consecutive
+    // requests reuse the connection or at least resume the TLS session
+    CURLSH* share = nullptr;
+    // One lock per shared data kind, taken by libcurl through the share's
+    // lock callbacks when requests run on several threads
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+    RequestScheduler* scheduler = nullptr;
+    std::map<std::string, InstrumentSpec> instrumentSpecs;
+    std::string account;
+    MetricGauge* inFlightRequests = nullptr;
+    std::map<std::string, MethodMetrics, std::less<>> methodMetrics;
     const std::string baseUrl = "https://test.deribit.com/api/v2/";
 };
 
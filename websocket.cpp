@@ -1,29 +1,70 @@
 #include "websocket.hpp"
 #include "logger.hpp"
+#include "tls_context.hpp"
+#include "alloc_counter.hpp"
+#include "metrics.hpp"
+#include "request_scheduler.hpp"
+#include "rx_timestamps.hpp"
+#include "tracing.hpp"
 #include <websocketpp/common/thread.hpp>
 #include <thread>
 #include <chrono>
 #include <stdexcept>
 #include <atomic>
+#include <cstring>
+#include <algorithm>
 
 DeribitWebSocketClient::DeribitWebSocketClient(
     const std::string& uri,
     const std::string& client_id,
-    const std::string& client_secret
+    const std::string& client_secret,
+    const std::string& connection_label,
+    boost::asio::io_service* io_service
 ) :
     m_uri(uri),
     m_client_id(client_id),
     m_client_secret(client_secret),
-    m_idCounter(1) // Initialize atomic ID counter
+    m_connectionLabel(connection_label),
+    m_idCounter(1), // Initialize atomic ID counter
+    m_editCoalescer([this] { return getNextId(); },
+                    [this](int id, const std::string& orderId, const Decimal& amount, const Decimal& price) {
+                        sendEdit(id, orderId, amount, price);
+                    },
+                    MetricsRegistry::label("connection", connection_label)),
+    m_marketData([this](const std::string& channel, const std::string& instrument) {
+                     requestBookSnapshot(channel, instrument);
+                 },
+                 MetricsRegistry::label("connection", connection_label))
 {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    const std::string labels = MetricsRegistry::label("connection", m_connectionLabel);
+    m_metrics.messagesSent = &metrics.counter("deribit_ws_messages_sent_total", labels);
+    m_metrics.bytesSent = &metrics.counter("deribit_ws_bytes_sent_total", labels);
+    m_metrics.parseErrors = &metrics.counter("deribit_ws_parse_errors_total", labels);
+    m_metrics.reconnects = &metrics.counter("deribit_ws_reconnects_total", labels);
+    m_metrics.outboundQueueDepth = &metrics.gauge("deribit_ws_outbound_queue_depth", labels);
+    m_metrics.inFlightRequests = &metrics.gauge("deribit_ws_in_flight_requests", labels);
+    m_metrics.requestLatency = &metrics.histogram("deribit_ws_request_latency_us", labels);
+    m_metrics.frameProcessing = &metrics.histogram("deribit_ws_frame_processing_us", labels);
+    m_metrics.rxKernelToRead = &metrics.histogram("deribit_ws_rx_stage_ns", labels + ",stage=\"kernel_to_read\"");
+    m_metrics.rxReadToDecrypt = &metrics.histogram("deribit_ws_rx_stage_ns", labels + ",stage=\"read_to_decrypt\"");
+    m_metrics.rxParse = &metrics.histogram("deribit_ws_rx_stage_ns", labels + ",stage=\"parse\"");
+    m_metrics.rxDispatch = &metrics.histogram("deribit_ws_rx_stage_ns", labels + ",stage=\"dispatch\"");
+
     try {
-        LOG_INFO("Initializing WebSocket client for " + uri);
+        LOG_INFO("Initializing WebSocket client for {}", uri);
         m_client.set_access_channels(websocketpp::log::alevel::none);
         m_client.set_error_channels(websocketpp::log::elevel::all);
 
-        m_client.init_asio();
+        if (io_service) {
+            m_client.init_asio(io_service);
+        } else {
+            m_client.init_asio();
+        }
+        m_drainTimer = std::make_unique<boost::asio::steady_timer>(m_client.get_io_service());
 
         m_client.set_tls_init_handler(std::bind(&DeribitWebSocketClient::onTLSInit, this, std::placeholders::_1));
+        m_client.set_socket_init_handler(std::bind(&DeribitWebSocketClient::onSocketInit, this, std::placeholders::_1, std::placeholders::_2));
 
         m_client.set_open_handler(std::bind(&DeribitWebSocketClient::onOpen, this, std::placeholders::_1));
         m_client.set_close_handler(std::bind(&DeribitWebSocketClient::onClose, this, std::placeholders::_1));
@@ -34,7 +75,7 @@ DeribitWebSocketClient::DeribitWebSocketClient(
         LOG_INFO("WebSocket client initialization complete");
     }
     catch (const std::exception& e) {
-        LOG_ERROR_CTX("WebSocket Initialization", e.what());
+        LOG_ERROR_CTX("WebSocket Initialization", "{}", e.what());
     }
 }
 
@@ -43,21 +84,23 @@ int DeribitWebSocketClient::getNextId() {
 }
 
 void DeribitWebSocketClient::connect() {
-    LOG_INFO("Connecting to WebSocket server: " + m_uri);
-    START_MEASUREMENT(websocket_connect);
+    LOG_INFO("Connecting to WebSocket server: {}", m_uri);
+    // Completed in onOpen so the measurement covers TCP connect and the TLS handshake
+    LOG_INFO("Starting measurement: websocket_connect");
+    m_connectStart.store(std::chrono::high_resolution_clock::now(), std::memory_order_release);
     
     websocketpp::lib::error_code ec;
     client::connection_ptr con = m_client.get_connection(m_uri, ec);
     if (ec) {
-        LOG_ERROR_CTX("WebSocket Connection Creation", ec.message());
-        END_MEASUREMENT(websocket_connect);
+        LOG_ERROR_CTX("WebSocket Connection Creation", "{}", ec.message());
+        const int64_t elapsed = Logger::elapsedMicros(m_connectStart.load(std::memory_order_relaxed));
+        LOG_LATENCY("websocket_connect completed in {} microseconds ({} ms)", elapsed, elapsed / 1000.0);
         return;
     }
     m_hdl = con->get_handle();
     m_client.connect(con);
     
     LOG_INFO("WebSocket connection initiated");
-    END_MEASUREMENT(websocket_connect);
 }
 
 void DeribitWebSocketClient::authenticate() {
@@ -77,13 +120,13 @@ void DeribitWebSocketClient::authenticate() {
         }}
     };
 
-    m_messageTimes[std::to_string(id)] = std::chrono::high_resolution_clock::now();
+    trackRequest(id);
     send(auth_payload);
     LOG_INFO("Authentication request sent");
 }
 
 void DeribitWebSocketClient::publicSubscribe(const std::vector<std::string>& channels) {
-    LOG_INFO("Subscribing to public channels: " + channels[0]);
+    LOG_INFO("Subscribing to public channels: {}", channels[0]);
     START_MEASUREMENT(public_subscribe);
     
     using json = nlohmann::json;
@@ -96,13 +139,13 @@ void DeribitWebSocketClient::publicSubscribe(const std::vector<std::string>& cha
         {"params", {{"channels", channels}}}
     };
 
-    m_messageTimes[std::to_string(id)] = std::chrono::high_resolution_clock::now();
+    trackRequest(id);
     send(subscribe_payload);
     END_MEASUREMENT(public_subscribe);
 }
 
 void DeribitWebSocketClient::privateSubscribe(const std::vector<std::string>& channels) {
-    LOG_INFO("Subscribing to private channels: " + channels[0]);
+    LOG_INFO("Subscribing to private channels: {}", channels[0]);
     START_MEASUREMENT(private_subscribe);
 
     try {
@@ -126,18 +169,18 @@ void DeribitWebSocketClient::privateSubscribe(const std::vector<std::string>& ch
             {"params", {{"channels", channels}}}
         };
 
-        m_messageTimes[std::to_string(id)] = std::chrono::high_resolution_clock::now();
+        trackRequest(id);
         send(request);
         LOG_INFO("Private subscription request sent");
 
     } catch (const std::exception& e) {
-        LOG_ERROR_CTX("Private Subscribe", e.what());
+        LOG_ERROR_CTX("Private Subscribe", "{}", e.what());
         END_MEASUREMENT(private_subscribe);
     }
 }
 
 void DeribitWebSocketClient::publicUnsubscribe(const std::vector<std::string>& channels) {
-    LOG_INFO("Unsubscribing from public channels: " + channels[0]);
+    LOG_INFO("Unsubscribing from public channels: {}", channels[0]);
     START_MEASUREMENT(public_unsubscribe);
 
     try {
@@ -156,17 +199,17 @@ void DeribitWebSocketClient::publicUnsubscribe(const std::vector<std::string>& c
             {"params", {{"channels", channels}}}
         };
 
-        m_messageTimes[std::to_string(id)] = std::chrono::high_resolution_clock::now();
+        trackRequest(id);
         send(request);
         END_MEASUREMENT(public_unsubscribe);
     } catch (const std::exception& e) {
-        LOG_ERROR_CTX("Public Unsubscribe", e.what());
+        LOG_ERROR_CTX("Public Unsubscribe", "{}", e.what());
         END_MEASUREMENT(public_unsubscribe);
     }
 }
 
 void DeribitWebSocketClient::privateUnsubscribe(const std::vector<std::string>& channels) {
-    LOG_INFO("Unsubscribing from private channels: " + channels[0]);
+    LOG_INFO("Unsubscribing from private channels: {}", channels[0]);
     START_MEASUREMENT(private_unsubscribe);
 
     try {
@@ -190,15 +233,43 @@ void DeribitWebSocketClient::privateUnsubscribe(const std::vector<std::string>&
             {"params", {{"channels", channels}}}
         };
 
-        m_messageTimes[std::to_string(id)] = std::chrono::high_resolution_clock::now();
+        trackRequest(id);
         send(request);
         END_MEASUREMENT(private_unsubscribe);
     } catch (const std::exception& e) {
-        LOG_ERROR_CTX("Private Unsubscribe", e.what());
+        LOG_ERROR_CTX("Private Unsubscribe", "{}", e.what());
         END_MEASUREMENT(private_unsubscribe);
     }
 }
 
+EditCoalescer::Result DeribitWebSocketClient::amendOrder(const std::string& orderId, const Decimal& amount,
+                                                        const Decimal& price) {
+    return m_editCoalescer.amend(orderId, amount, price);
+}
+
+void DeribitWebSocketClient::sendEdit(int id, const std::string& orderId, const Decimal& amount,
+                                      const Decimal& price) {
+    // The nearest double prints back as the same decimal: json writes the
+    // shortest representation that round-trips
+    nlohmann::json params = {{"order_id", orderId}};
+    if (amount.units() > 0) {
+        params["amount"] = amount.toDouble();
+    }
+    if (price.units() > 0) {
+        params["price"] = price.toDouble();
+    }
+
+    nlohmann::json request = {
+        {"jsonrpc", "2.0"},
+        {"method", "private/edit"},
+        {"id", id},
+        {"params", params}
+    };
+
+    trackRequest(id);
+    send(request);
+}
+
 void DeribitWebSocketClient::run() {
     LOG_INFO("Starting WebSocket IO service");
     m_client.run();
@@ -207,12 +278,38 @@ void DeribitWebSocketClient::run() {
 
 void DeribitWebSocketClient::onOpen(connection_hdl hdl) {
     LOG_INFO("WebSocket connection established");
-    m_isConnected = true;
+    std::unique_ptr<nlohmann::json> queuedPayload;
+    {
+        // send() checks the flag under the same lock, so a message is
+        // either taken here or sent directly, never left behind
+        std::lock_guard<std::mutex> lock(m_outboundMutex);
+        m_isConnected = true;
+        queuedPayload = std::move(m_queuedPayload);
+    }
+    if (m_openCount++ > 0) {
+        m_metrics.reconnects->add();
+    }
 
-    if (m_queuedPayload) {
+    auto con = m_client.get_con_from_hdl(hdl);
+    bool resumed = TLSContextManager::getInstance().wasResumed(con->get_socket().native_handle());
+    const int64_t elapsed = Logger::elapsedMicros(m_connectStart.load(std::memory_order_acquire));
+    LOG_LATENCY("websocket_connect ({}) completed in {} microseconds ({} ms)",
+                resumed ? "TLS resumed" : "TLS full handshake", elapsed, elapsed / 1000.0);
+
+    if (RxTimestamping::supported()) {
+        const int fd = con->get_socket().lowest_layer().native_handle();
+        if (RxTimestamping::enable(fd)) {
+            m_rxTimestampFd = fd;
+            LOG_INFO("Kernel RX timestamps enabled on socket {}", fd);
+        } else {
+            LOG_WARNING("Kernel RX timestamps unavailable on socket {}", fd);
+        }
+    }
+
+    if (queuedPayload) {
         LOG_INFO("Sending queued message");
-        send(*m_queuedPayload);
-        m_queuedPayload.reset();
+        m_metrics.outboundQueueDepth->add(-1);
+        send(*queuedPayload);
     }
 
     authenticate();
@@ -222,12 +319,33 @@ void DeribitWebSocketClient::onClose(connection_hdl hdl) {
     auto con = m_client.get_con_from_hdl(hdl);
     m_isConnected = false;
     m_isAuthenticated = false;
+    m_editCoalescer.reset();
+    m_marketData.reset();
+    m_snapshotRequests.clear();
+    {
+        // Frames paced for the old connection are not replayed on a new one
+        std::lock_guard<std::mutex> lock(m_outboundMutex);
+        for (auto& queue : m_outbound) {
+            m_metrics.outboundQueueDepth->add(-static_cast<int64_t>(queue.size()));
+            queue.clear();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_traceMutex);
+        m_requestTraces.clear();
+    }
+    // The descriptor may be reused by an unrelated socket
+    RxTimestamping::disable(m_rxTimestampFd);
+    m_rxTimestampFd = -1;
 
     auto close_code = con->get_remote_close_code();
     auto close_reason = con->get_remote_close_reason();
 
+    LOG_INFO("Heap allocations while handling frames: {} in {} of {} frames", m_allocationStats.allocations,
+             m_allocationStats.framesWithAllocations, m_allocationStats.frames);
+
     if (close_code != websocketpp::close::status::normal) {
-        LOG_WARNING("WebSocket closed with code: " + std::to_string(close_code) + ", Reason: " + close_reason);
+        LOG_WARNING("WebSocket closed with code: {}, Reason: {}", close_code, close_reason);
     } else {
         LOG_INFO("WebSocket connection closed normally");
     }
@@ -235,66 +353,117 @@ void DeribitWebSocketClient::onClose(connection_hdl hdl) {
 
 void DeribitWebSocketClient::onFail(connection_hdl hdl) {
     auto con = m_client.get_con_from_hdl(hdl);
-    LOG_ERROR_CTX("WebSocket Connection", "Connection failed: " + con->get_ec().message());
+    LOG_ERROR_CTX("WebSocket Connection", "Connection failed: {}", con->get_ec().message());
 }
 
 void DeribitWebSocketClient::onMessage(connection_hdl hdl, client::message_ptr msg) {
-    using json = nlohmann::json;
     START_MEASUREMENT(message_processing);
+    // Everything parsed for this frame lives in the thread's arena and is
+    // released in one step when the frame is done
+    MessageArena::Scope frame;
+    ScopedLatency frameLatency(*m_metrics.frameProcessing);
+    const uint64_t allocationsBefore = AllocationCounter::threadAllocations();
+    const bool rxTimestamps = m_rxTimestampFd >= 0;
+    const int64_t decryptedNs = rxTimestamps ? RxTimestamping::nowNs() : 0;
+    int64_t parsedNs = 0;
 
     try {
-        auto parsed_msg = json::parse(msg->get_payload());
+        ArenaDocument document(msg->get_payload());
+        const arena_json& parsed_msg = document.json();
+        if (rxTimestamps) {
+            parsedNs = RxTimestamping::nowNs();
+        }
+
+        std::string_view channel = "rpc";
+        auto params = parsed_msg.find("params");
+        if (params != parsed_msg.end() && params->is_object() && params->contains("channel")) {
+            const auto& channelName = (*params)["channel"].get_ref<const arena_json::string_t&>();
+            channel = std::string_view(channelName.data(), channelName.size());
+        }
+        ChannelMetrics& channelMetrics = metricsForChannel(channel);
+        channelMetrics.messages->add();
+        channelMetrics.bytes->add(msg->get_payload().size());
 
         if (parsed_msg.contains("id") && parsed_msg["id"].is_number()) {
-            std::string id_str = std::to_string(parsed_msg["id"].get<int>());
-            auto it = m_messageTimes.find(id_str);
+            const int requestId = parsed_msg["id"].get<int>();
+            std::unique_lock<std::mutex> lock(m_messageTimesMutex);
+            auto it = m_messageTimes.find(requestId);
             if (it != m_messageTimes.end()) {
                 auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
                     std::chrono::high_resolution_clock::now() - it->second
                 ).count();
-                LOG_INFO("Latency for ID " + id_str + ": " + std::to_string(latency) + "µs (" + std::to_string(latency / 1000.0) + "ms)");
                 m_messageTimes.erase(it);
+                m_metrics.inFlightRequests->set(static_cast<int64_t>(m_messageTimes.size()));
+                lock.unlock();
+                LOG_INFO("Latency for ID {}: {}µs ({}ms)", requestId, latency, latency / 1000.0);
+                m_metrics.requestLatency->record(latency);
             }
         }
 
-        if (parsed_msg.contains("error")) {
-            LOG_ERROR_CTX("WebSocket Error", parsed_msg["error"].dump(4));
-            END_MEASUREMENT(message_processing);
-            return;
+        auto id = parsed_msg.find("id");
+        if (id != parsed_msg.end() && id->is_number_integer()) {
+            traceResponse(id->get<int>(), parsed_msg);
+            m_editCoalescer.onResponse(id->get<int>(), !parsed_msg.contains("error"));
+            auto snapshot = m_snapshotRequests.find(id->get<int>());
+            if (snapshot != m_snapshotRequests.end()) {
+                const std::string bookChannel = std::move(snapshot->second);
+                m_snapshotRequests.erase(snapshot);
+                m_marketData.onBookSnapshot(bookChannel, parsed_msg);
+            }
         }
 
-        if (parsed_msg.contains("method")) {
-            processMethod(parsed_msg);
+        if (parsed_msg.contains("error")) {
+            const arena_json& error = parsed_msg["error"];
+            if (m_scheduler && error.is_object() && error.value("code", 0) == RequestScheduler::kTooManyRequests) {
+                m_scheduler->onThrottled();
+            }
+            LOG_ERROR_CTX("WebSocket Error", "{}", error.dump(4));
+        } else if (parsed_msg.contains("method")) {
+            m_marketData.onNotification(parsed_msg);
         } else if (parsed_msg.contains("result")) {
             processResult(parsed_msg);
         }
+    } catch (const arena_json::parse_error& e) {
+        m_metrics.parseErrors->add();
+        LOG_ERROR_CTX("Message Processing", "{}", e.what());
     } catch (const std::exception& e) {
-        LOG_ERROR_CTX("Message Processing", e.what());
+        LOG_ERROR_CTX("Message Processing", "{}", e.what());
+    }
+
+    if (parsedNs > 0) {
+        // websocketpp reads, decrypts and reassembles before onMessage, so
+        // read_to_decrypt covers TLS and websocket framing together
+        RxTimestamping::Sample rx;
+        if (RxTimestamping::take(m_rxTimestampFd, rx)) {
+            m_metrics.rxKernelToRead->record(static_cast<uint64_t>(std::max<int64_t>(rx.readNs - rx.kernelNs, 0)));
+            m_metrics.rxReadToDecrypt->record(static_cast<uint64_t>(std::max<int64_t>(decryptedNs - rx.readNs, 0)));
+        }
+        m_metrics.rxParse->record(static_cast<uint64_t>(std::max<int64_t>(parsedNs - decryptedNs, 0)));
+        m_metrics.rxDispatch->record(static_cast<uint64_t>(std::max<int64_t>(RxTimestamping::nowNs() - parsedNs, 0)));
+    }
+
+    uint64_t allocations = AllocationCounter::threadAllocations() - allocationsBefore;
+    m_allocationStats.frames++;
+    if (allocations > 0) {
+        m_allocationStats.framesWithAllocations++;
+        m_allocationStats.allocations += allocations;
     }
 
     END_MEASUREMENT(message_processing);
 }
 
 DeribitWebSocketClient::context_ptr DeribitWebSocketClient::onTLSInit(connection_hdl) {
-    context_ptr ctx = websocketpp::lib::make_shared<boost::asio::ssl::context>(
-        boost::asio::ssl::context::tlsv12_client
-    );
+    return TLSContextManager::getInstance().getContext();
+}
 
+void DeribitWebSocketClient::onSocketInit(connection_hdl hdl,
+                                          boost::asio::ssl::stream<boost::asio::ip::tcp::socket>& socket) {
     try {
-        ctx->set_verify_mode(boost::asio::ssl::verify_none);
-        ctx->set_default_verify_paths();
-        ctx->set_verify_callback([](bool preverified, boost::asio::ssl::verify_context& ctx) {
-            char subject_name[256];
-            X509* cert = X509_STORE_CTX_get_current_cert(ctx.native_handle());
-            X509_NAME_oneline(X509_get_subject_name(cert), subject_name, sizeof(subject_name));
-            return preverified;
-        });
-        LOG_INFO("TLS context initialized successfully");
+        auto con = m_client.get_con_from_hdl(hdl);
+        TLSContextManager::getInstance().prepareConnection(socket.native_handle(), con->get_host());
     } catch (const std::exception& e) {
-        LOG_ERROR_CTX("TLS Initialization", e.what());
+        LOG_ERROR_CTX("TLS Initialization", "{}", e.what());
     }
-
-    return ctx;
 }
 
 void DeribitWebSocketClient::send(const nlohmann::json& payload) {
@@ -302,15 +471,21 @@ void DeribitWebSocketClient::send(const nlohmann::json& payload) {
     websocketpp::lib::error_code ec;
 
     if (!m_isConnected) {
-        LOG_INFO("Connection not yet open, queuing message...");
-        m_queuedPayload = std::make_unique<nlohmann::json>(payload);
-        END_MEASUREMENT(websocket_send);
-        return;
+        std::lock_guard<std::mutex> lock(m_outboundMutex);
+        if (!m_isConnected) {
+            LOG_INFO("Connection not yet open, queuing message...");
+            if (!m_queuedPayload) {
+                m_metrics.outboundQueueDepth->add(1);
+            }
+            m_queuedPayload = std::make_unique<nlohmann::json>(payload);
+            END_MEASUREMENT(websocket_send);
+            return;
+        }
     }
 
     auto con = m_client.get_con_from_hdl(m_hdl, ec);
     if (ec) {
-        LOG_ERROR_CTX("Error retrieving connection", ec.message());
+        LOG_ERROR_CTX("Error retrieving connection", "{}", ec.message());
         END_MEASUREMENT(websocket_send);
         return;
     }
@@ -321,46 +496,196 @@ void DeribitWebSocketClient::send(const nlohmann::json& payload) {
         return;
     }
 
-    m_client.send(m_hdl, payload.dump(), websocketpp::frame::opcode::text, ec);
+    OutboundFrame frame;
+    {
+        TRACE_SPAN("encode");
+        frame.text = payload.dump();
+    }
+    frame.traceId = Tracer::currentTraceId();
+    auto id = payload.find("id");
+    frame.requestId = frame.traceId && id != payload.end() && id->is_number_integer() ? id->get<int>() : 0;
+
+    if (m_scheduler) {
+        bool reduceOnly = false;
+        auto params = payload.find("params");
+        if (params != payload.end() && params->is_object()) {
+            reduceOnly = params->value("reduce_only", false);
+        }
+        const size_t priority = static_cast<size_t>(
+            RequestScheduler::classify(payload.value("method", std::string()), reduceOnly));
+
+        std::lock_guard<std::mutex> lock(m_outboundMutex);
+        bool ahead = false;
+        for (size_t p = 0; p <= priority; ++p) {
+            ahead = ahead || !m_outbound[p].empty();
+        }
+        bool paid = false;
+        if (!ahead) {
+            TRACE_SPAN("enqueue");
+            paid = m_scheduler->tryAcquire(static_cast<RequestScheduler::Priority>(priority));
+        }
+        if (!paid) {
+            // Sent by drainOutbound() once the bucket can pay and nothing
+            // more urgent is waiting
+            frame.queuedNs = Tracer::nowNs();
+            m_outbound[priority].push_back(std::move(frame));
+            m_metrics.outboundQueueDepth->add(1);
+            armDrain(m_scheduler->untilAffordable());
+            END_MEASUREMENT(websocket_send);
+            return;
+        }
+    }
+    write(frame);
+
+    END_MEASUREMENT(websocket_send);
+}
+
+void DeribitWebSocketClient::write(const OutboundFrame& frame) {
+    websocketpp::lib::error_code ec;
+    // Registered before writing so a fast response always finds it
+    if (frame.requestId) {
+        std::lock_guard<std::mutex> lock(m_traceMutex);
+        m_requestTraces[frame.requestId] = PendingTrace{frame.traceId, Tracer::nowNs()};
+    }
+    const int64_t writeStartNs = frame.traceId ? Tracer::nowNs() : 0;
+    m_client.send(m_hdl, frame.text, websocketpp::frame::opcode::text, ec);
+    if (frame.traceId) {
+        Tracer::getInstance().record(frame.traceId, "socket_write", writeStartNs, Tracer::nowNs());
+    }
+    if (frame.requestId) {
+        std::lock_guard<std::mutex> lock(m_traceMutex);
+        auto pending = m_requestTraces.find(frame.requestId);
+        if (pending != m_requestTraces.end()) {
+            if (ec) {
+                m_requestTraces.erase(pending);
+            } else {
+                pending->second.writtenNs = Tracer::nowNs();
+            }
+        }
+    }
     if (ec) {
-        LOG_ERROR_CTX("Message Send", ec.message());
+        LOG_ERROR_CTX("Message Send", "{}", ec.message());
     } else {
+        m_metrics.messagesSent->add();
+        m_metrics.bytesSent->add(frame.text.size());
         LOG_INFO("Message sent successfully");
     }
+}
 
-    END_MEASUREMENT(websocket_send);
+void DeribitWebSocketClient::armDrain(std::chrono::microseconds delay) {
+    if (m_drainArmed) {
+        return;
+    }
+    m_drainArmed = true;
+    // Never spin: a bucket that can pay but has blocking REST callers
+    // queued ahead is retried shortly
+    m_drainTimer->expires_after(std::max(delay, std::chrono::microseconds(1000)));
+    m_drainTimer->async_wait([this](const boost::system::error_code& ec) {
+        if (!ec) {
+            drainOutbound();
+        }
+    });
 }
 
-void DeribitWebSocketClient::processMethod(const nlohmann::json& msg) {
-    if (msg["method"] == "subscription") {
-        START_MEASUREMENT(subscription_processing);
-        handleSubscriptionData(msg);
-        END_MEASUREMENT(subscription_processing);
+void DeribitWebSocketClient::drainOutbound() {
+    std::lock_guard<std::mutex> lock(m_outboundMutex);
+    m_drainArmed = false;
+    size_t remaining = 0;
+    for (size_t priority = 0; priority < RequestScheduler::kPriorities; ++priority) {
+        auto& queue = m_outbound[priority];
+        // Lower priorities wait while a higher one cannot be paid for
+        while (remaining == 0 && !queue.empty() &&
+               m_scheduler->tryAcquire(static_cast<RequestScheduler::Priority>(priority))) {
+            const OutboundFrame& frame = queue.front();
+            if (frame.traceId) {
+                Tracer::getInstance().record(frame.traceId, "enqueue", frame.queuedNs, Tracer::nowNs());
+            }
+            write(frame);
+            queue.pop_front();
+            m_metrics.outboundQueueDepth->add(-1);
+        }
+        remaining += queue.size();
+    }
+    if (remaining > 0) {
+        armDrain(m_scheduler->untilAffordable());
+    }
+}
+
+void DeribitWebSocketClient::traceResponse(int id, const arena_json& msg) {
+    PendingTrace pending;
+    {
+        std::lock_guard<std::mutex> lock(m_traceMutex);
+        auto it = m_requestTraces.find(id);
+        if (it == m_requestTraces.end()) {
+            return;
+        }
+        pending = it->second;
+        m_requestTraces.erase(it);
+    }
+    Tracer& tracer = Tracer::getInstance();
+    tracer.record(pending.traceId, "exchange_ack", pending.writtenNs, Tracer::nowNs());
+
+    auto result = msg.find("result");
+    if (result != msg.end() && result->is_object()) {
+        auto order = result->find("order");
+        if (order != result->end() && order->is_object()) {
+            auto orderId = order->find("order_id");
+            if (orderId != order->end() && orderId->is_string()) {
+                const auto& value = orderId->get_ref<const arena_json::string_t&>();
+                tracer.bindOrder(std::string_view(value.data(), value.size()), pending.traceId);
+            }
+        }
+    }
+}
+
+void DeribitWebSocketClient::trackRequest(int id) {
+    std::lock_guard<std::mutex> lock(m_messageTimesMutex);
+    m_messageTimes[id] = std::chrono::high_resolution_clock::now();
+    m_metrics.inFlightRequests->set(static_cast<int64_t>(m_messageTimes.size()));
+}
+
+DeribitWebSocketClient::ChannelMetrics& DeribitWebSocketClient::metricsForChannel(std::string_view channel) {
+    auto it = m_channelMetrics.find(channel);
+    if (it != m_channelMetrics.end()) {
+        return it->second;
     }
+
+    // First message on this channel: register its series once
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    const std::string labels = MetricsRegistry::label("connection", m_connectionLabel) + "," +
+                               MetricsRegistry::label("channel", channel);
+    ChannelMetrics entry;
+    entry.messages = &metrics.counter("deribit_ws_messages_received_total", labels);
+    entry.bytes = &metrics.counter("deribit_ws_bytes_received_total", labels);
+    return m_channelMetrics.emplace(std::string(channel), entry).first->second;
 }
 
-void DeribitWebSocketClient::processResult(const nlohmann::json& msg) {
+void DeribitWebSocketClient::processResult(const arena_json& msg) {
     if (msg.contains("id") && msg["id"] == 1 && msg.contains("result")) {
         LOG_INFO("Authentication Successful!");
         m_isAuthenticated = true;
     } else {
-        LOG_INFO("Received result for ID: " + std::to_string(msg["id"].get<int>()));
+        LOG_INFO("Received result for ID: {}", msg["id"].get<int>());
     }
 }
 
-void DeribitWebSocketClient::handleSubscriptionData(const nlohmann::json& msg) {
-    if (msg.contains("params") && msg["params"].contains("data")) {
-        auto market_data = msg["params"]["data"];
-        LOG_INFO("Market Update received");
-        if (msg["params"].contains("channel")) {
-            LOG_INFO("Channel: " + msg["params"]["channel"].get<std::string>());
-        }
+void DeribitWebSocketClient::requestBookSnapshot(const std::string& channel, const std::string& instrument) {
+    LOG_WARNING("Book {} is stale, requesting snapshot for {}", channel, instrument);
+    const int id = getNextId();
+    m_snapshotRequests[id] = channel;
 
-        std::cout << "Market Update: " << market_data.dump(4) << std::endl;
-    }
+    nlohmann::json request = {
+        {"jsonrpc", "2.0"},
+        {"method", "public/get_order_book"},
+        {"id", id},
+        {"params", {{"instrument_name", instrument}, {"depth", OrderBook::kMaxDepth}}}
+    };
+
+    trackRequest(id);
+    send(request);
 }
 
 void DeribitWebSocketClient::logError(const std::string& context, const std::string& error) {
-    LOG_ERROR_CTX(context, error);
+    LOG_ERROR("[{}] {}", context, error);
     std::cerr << "[" << context << "] Error: " << error << std::endl;
 }
@@ -13,6 +13,17 @@
 #include <map>
 #include <chrono>
 #include <atomic>
+#include <mutex>
+#include <deque>
+#include <boost/asio/steady_timer.hpp>
+#include "message_arena.hpp"
+#include "edit_coalescer.hpp"
+#include "market_data_handler.hpp"
+#include "request_scheduler.hpp"
+
+class MetricCounter;
+class MetricGauge;
+class LatencyHistogram;
 
 
 class DeribitWebSocketClient {
@@ -24,7 +35,11 @@ public:
     DeribitWebSocketClient(
         const std::string& uri,
         const std::string& client_id,
-        const std::string& client_secret
+        const std::string& client_secret,
+        const std::string& connection_label = "main",
+        // Shared io_service run by the caller's thread pool; null gives the
+        // client its own, driven by run()
+        boost::asio::io_service* io_service = nullptr
     );
 
     void connect();
@@ -36,6 +51,36 @@ public:
     void publicUnsubscribe(const std::vector<std::string>& channels);
     void privateUnsubscribe(const std::vector<std::string>& channels);
 
+    // Amends an order via private/edit, keeping at most one edit in flight
+    // per order; amendments made meanwhile are merged and sent on the ack.
+    // Zero amount or price leaves that field unchanged.
+    EditCoalescer::Result amendOrder(const std::string& orderId, const Decimal& amount, const Decimal& price);
+
+    // Latest per-instrument top-of-book/ticker state for consumer threads
+    ConflationQueue& marketState() { return m_marketData.marketState(); }
+    // Lossless stream of decoded trades, book changes and order updates
+    EventBus& events() { return m_marketData.events(); }
+    // OHLCV bars and rolling VWAP/volume built from trades.* channels
+    TradeAggregator& tradeAggregates() { return m_marketData.tradeAggregates(); }
+    // Implied vols and Greeks per underlying from option ticker.* channels; IO thread only
+    const OptionChainEngine& optionChains() const { return m_marketData.optionChains(); }
+    // Sequence-checked books per book.* channel, resynced from snapshots on gaps; IO thread only
+    const BookSynchronizer& books() const { return m_marketData.books(); }
+    // Optional: mirror decoded state and trades into shared memory
+    void setSharedMemoryPublisher(ShmMarketDataPublisher* publisher) { m_marketData.setSharedMemoryPublisher(publisher); }
+    // Optional: echo every market update to stdout (allocates per frame)
+    void setPrintUpdates(bool print) { m_marketData.setPrintUpdates(print); }
+    // Optional: pace requests through the account's shared credit bucket
+    void setScheduler(RequestScheduler* scheduler) { m_scheduler = scheduler; }
+
+    // Global heap allocations made while handling inbound frames
+    struct AllocationStats {
+        uint64_t frames = 0;
+        uint64_t framesWithAllocations = 0;
+        uint64_t allocations = 0;
+    };
+    const AllocationStats& allocationStats() const { return m_allocationStats; }
+
 private:
     // WebSocket event handlers
     void onOpen(connection_hdl hdl);
@@ -43,13 +88,35 @@ private:
     void onFail(connection_hdl hdl);
     void onMessage(connection_hdl hdl, client::message_ptr msg);
     context_ptr onTLSInit(connection_hdl hdl);
+    void onSocketInit(connection_hdl hdl, boost::asio::ssl::stream<boost::asio::ip::tcp::socket>& socket);
+
+    // Frame the credit bucket could not pay for yet
+    struct OutboundFrame {
+        std::string text;
+        int requestId = 0;          // Traced request awaiting its response, else 0
+        uint64_t traceId = 0;
+        int64_t queuedNs = 0;
+    };
 
-    // Message processing
+    // Message processing. send() never blocks: with a scheduler, frames
+    // the bucket cannot pay for now are queued by priority and sent from
+    // m_drainTimer
     void send(const nlohmann::json& payload);
-    void processMethod(const nlohmann::json& msg);
-    void processResult(const nlohmann::json& msg);
-    void handleSubscriptionData(const nlohmann::json& msg);
+    void write(const OutboundFrame& frame);
+    void drainOutbound();
+    void armDrain(std::chrono::microseconds delay);     // Caller holds m_outboundMutex
+    void processResult(const arena_json& msg);
+    void requestBookSnapshot(const std::string& channel, const std::string& instrument);
     void logError(const std::string& context, const std::string& error);
+    void trackRequest(int id);
+    void traceResponse(int id, const arena_json& msg);
+    void sendEdit(int id, const std::string& orderId, const Decimal& amount, const Decimal& price);
+
+    struct ChannelMetrics {
+        MetricCounter* messages = nullptr;
+        MetricCounter* bytes = nullptr;
+    };
+    ChannelMetrics& metricsForChannel(std::string_view channel);
 
     // WebSocket client instance
     std::atomic<int> m_idCounter;
@@ -58,12 +125,61 @@ private:
     std::string m_uri;
     std::string m_client_id;
     std::string m_client_secret;
-    bool m_isConnected = false;
-    bool m_isAuthenticated = false;
+    std::string m_connectionLabel;
+    // Set by the connection's handlers, read by senders on any thread
+    std::atomic<bool> m_isConnected{false};
+    std::atomic<bool> m_isAuthenticated{false};
 
-    // Message queue for messages that need to be sent after connection is established
+    // Message to send once the connection is established; guarded by
+    // m_outboundMutex, under which onOpen() also sets m_isConnected
     std::unique_ptr<nlohmann::json> m_queuedPayload;
     
-    // Latency measurement
-    std::map<std::string, std::chrono::time_point<std::chrono::high_resolution_clock>> m_messageTimes;
+    // Latency measurement: request id -> sent at. Written by whichever
+    // thread sends and erased on the IO thread, so guarded by its own mutex
+    std::mutex m_messageTimesMutex;
+    std::map<int, std::chrono::time_point<std::chrono::high_resolution_clock>> m_messageTimes;
+    // Written by connect() on the caller's thread, read in onOpen on an IO thread
+    std::atomic<std::chrono::time_point<std::chrono::high_resolution_clock>> m_connectStart;
+
+    EditCoalescer m_editCoalescer;
+    MarketDataHandler m_marketData;
+    // get_order_book request id -> channel; connection handlers only
+    std::map<int, std::string> m_snapshotRequests;
+
+    // Traced requests awaiting their response: id -> (trace id, written at)
+    struct PendingTrace {
+        uint64_t traceId;
+        int64_t writtenNs;
+    };
+    std::mutex m_traceMutex;
+    std::map<int, PendingTrace> m_requestTraces;
+    RequestScheduler* m_scheduler = nullptr;
+
+    // Paced frames per priority, written in priority then arrival order
+    std::mutex m_outboundMutex;
+    std::deque<OutboundFrame> m_outbound[RequestScheduler::kPriorities];
+    std::unique_ptr<boost::asio::steady_timer> m_drainTimer;
+    bool m_drainArmed = false;
+    AllocationStats m_allocationStats;
+
+    // Live metrics, registered once in the constructor
+    struct {
+        MetricCounter* messagesSent = nullptr;
+        MetricCounter* bytesSent = nullptr;
+        MetricCounter* parseErrors = nullptr;
+        MetricCounter* reconnects = nullptr;
+        MetricGauge* outboundQueueDepth = nullptr;
+        MetricGauge* inFlightRequests = nullptr;
+        LatencyHistogram* requestLatency = nullptr;
+        LatencyHistogram* frameProcessing = nullptr;
+        // Per-frame receive path in ns: kernel stamp -> read -> decrypted
+        // frame in onMessage -> JSON parsed -> handlers done
+        LatencyHistogram* rxKernelToRead = nullptr;
+        LatencyHistogram* rxReadToDecrypt = nullptr;
+        LatencyHistogram* rxParse = nullptr;
+        LatencyHistogram* rxDispatch = nullptr;
+    } m_metrics;
+    std::map<std::string, ChannelMetrics, std::less<>> m_channelMetrics;
+    int m_openCount = 0;
+    int m_rxTimestampFd = -1;     // Socket with kernel RX timestamps enabled, if any
 };
\ No newline at end of file